@@ -0,0 +1,219 @@
+// Bench.h
+// Tiny micro-benchmark harness with baseline save / A-B compare.
+//
+// Each benchmark is run 'repeats' times; one repeat times 'iterations' calls
+// and contributes one ns/op sample. Mean, standard deviation and a 95%
+// confidence interval come from those samples. Comparing against a saved
+// baseline uses Welch's t-test (unequal variances), so a delta is only
+// called a regression or an improvement when it is both significant and
+// larger than the threshold.
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct BenchStats {
+    std::string name;
+    int n = 0;
+    double mean = 0.0;     // ns per op
+    double stddev = 0.0;
+    double ci95 = 0.0;     // half width
+};
+
+// Two-sided 95% critical value of Student's t.
+inline double tCritical95(double df) {
+    static const double TABLE[] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042 };
+    if (!(df >= 1.0)) return TABLE[0];
+    if (df <= 30.0) return TABLE[static_cast<int>(df) - 1];
+    if (df <= 60.0) return 2.000;
+    if (df <= 120.0) return 1.980;
+    return 1.960;
+}
+
+inline BenchStats summarize(const std::string& name, const std::vector<double>& samples) {
+    BenchStats s;
+    s.name = name;
+    s.n = static_cast<int>(samples.size());
+    if (s.n == 0) return s;
+    double sum = 0.0;
+    for (double v : samples) sum += v;
+    s.mean = sum / s.n;
+    if (s.n > 1) {
+        double sq = 0.0;
+        for (double v : samples) sq += (v - s.mean) * (v - s.mean);
+        s.stddev = std::sqrt(sq / (s.n - 1));
+        s.ci95 = tCritical95(s.n - 1) * s.stddev / std::sqrt(static_cast<double>(s.n));
+    }
+    return s;
+}
+
+// Time 'fn' (which performs one op per call). One untimed warm-up repeat first.
+template <typename F>
+BenchStats runBench(const std::string& name, int repeats, int iterations, F&& fn) {
+    using Clock = std::chrono::steady_clock;
+    std::vector<double> samples;
+    samples.reserve(repeats);
+    for (int r = -1; r < repeats; ++r) {
+        auto t0 = Clock::now();
+        for (int i = 0; i < iterations; ++i) fn(i);
+        auto t1 = Clock::now();
+        if (r < 0) continue;
+        samples.push_back(std::chrono::duration<double, std::nano>(t1 - t0).count() / iterations);
+    }
+    return summarize(name, samples);
+}
+
+// ---------------- Frame times ----------------
+// Whole-frame percentiles for the in-game flythrough (--benchmark).
+
+struct FrameTimeStats {
+    std::string name;
+    std::size_t frames = 0;
+    double p50 = 0.0;      // ms
+    double p99 = 0.0;
+    double max = 0.0;
+    double avgFps = 0.0;   // frames / total time
+};
+
+inline FrameTimeStats summarizeFrameTimes(const std::string& name, std::vector<float> frameMs) {
+    FrameTimeStats s;
+    s.name = name;
+    s.frames = frameMs.size();
+    if (frameMs.empty()) return s;
+    std::sort(frameMs.begin(), frameMs.end());
+    double sum = 0.0;
+    for (float ms : frameMs) sum += ms;
+    std::size_t n = frameMs.size();
+    s.p50 = frameMs[n / 2];
+    s.p99 = frameMs[std::min(n - 1, n * 99 / 100)];
+    s.max = frameMs.back();
+    s.avgFps = sum > 0.0 ? 1000.0 * n / sum : 0.0;
+    return s;
+}
+
+inline void printFrameTimeTable(const std::vector<FrameTimeStats>& results) {
+    std::printf("%-28s %8s %10s %10s %10s %10s\n", "level", "frames", "p50 ms", "p99 ms", "max ms", "avg FPS");
+    for (const auto& r : results) {
+        std::printf("%-28s %8zu %10.2f %10.2f %10.2f %10.1f\n", r.name.c_str(), r.frames, r.p50, r.p99, r.max, r.avgFps);
+    }
+}
+
+// ---------------- Baseline files ----------------
+// Plain text, one benchmark per line: name n mean stddev ci95
+
+inline bool saveBaseline(const std::string& path, const std::vector<BenchStats>& results) {
+    std::ofstream out(path);
+    if (!out) {
+        std::cout << "Cannot write baseline: " << path << "\n";
+        return false;
+    }
+    out.precision(10);
+    out << "# MyGame bench baseline v1 (ns/op)\n";
+    for (const auto& r : results) {
+        out << r.name << ' ' << r.n << ' ' << r.mean << ' ' << r.stddev << ' ' << r.ci95 << '\n';
+    }
+    return true;
+}
+
+inline bool loadBaseline(const std::string& path, std::vector<BenchStats>& results) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cout << "Cannot read baseline: " << path << "\n";
+        return false;
+    }
+    results.clear();
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream ss(line);
+        BenchStats s;
+        if (ss >> s.name >> s.n >> s.mean >> s.stddev >> s.ci95) results.push_back(s);
+    }
+    return true;
+}
+
+// ---------------- A/B compare ----------------
+
+enum class BenchVerdict { Same, Faster, Slower, Regression, New };
+
+struct BenchDelta {
+    std::string name;
+    double deltaPct = 0.0;     // (current - baseline) / baseline
+    double ciPct = 0.0;        // 95% half width of the difference, in % of baseline
+    bool significant = false;
+    BenchVerdict verdict = BenchVerdict::New;
+};
+
+inline BenchDelta compareBench(const BenchStats& base, const BenchStats& cur, double thresholdPct) {
+    BenchDelta d;
+    d.name = cur.name;
+    if (base.n < 2 || cur.n < 2 || base.mean <= 0.0) return d;
+
+    double va = base.stddev * base.stddev / base.n;
+    double vb = cur.stddev * cur.stddev / cur.n;
+    double se = std::sqrt(va + vb);
+    double diff = cur.mean - base.mean;
+
+    // Welch-Satterthwaite degrees of freedom
+    double df = (va + vb) * (va + vb);
+    double den = va * va / (base.n - 1) + vb * vb / (cur.n - 1);
+    df = den > 0.0 ? df / den : 1e9;
+
+    double half = tCritical95(df) * se;
+    d.deltaPct = 100.0 * diff / base.mean;
+    d.ciPct = 100.0 * half / base.mean;
+    d.significant = std::fabs(diff) > half;
+
+    if (!d.significant) d.verdict = BenchVerdict::Same;
+    else if (diff < 0.0) d.verdict = BenchVerdict::Faster;
+    else if (d.deltaPct > thresholdPct) d.verdict = BenchVerdict::Regression;
+    else d.verdict = BenchVerdict::Slower;
+    return d;
+}
+
+inline const char* verdictName(BenchVerdict v) {
+    switch (v) {
+    case BenchVerdict::Same:       return "same";
+    case BenchVerdict::Faster:     return "faster";
+    case BenchVerdict::Slower:     return "slower";
+    case BenchVerdict::Regression: return "REGRESSION";
+    case BenchVerdict::New:        return "new";
+    }
+    return "?";
+}
+
+inline void printBenchTable(const std::vector<BenchStats>& results) {
+    std::printf("%-34s %12s %12s %5s\n", "benchmark", "ns/op", "+/- 95%", "n");
+    for (const auto& r : results) {
+        std::printf("%-34s %12.1f %12.1f %5d\n", r.name.c_str(), r.mean, r.ci95, r.n);
+    }
+}
+
+// Prints one line per current benchmark; returns the number of regressions.
+inline int printComparison(const std::vector<BenchStats>& baseline, const std::vector<BenchStats>& current, double thresholdPct) {
+    int regressions = 0;
+    std::printf("%-34s %12s %12s %10s %10s  %s\n", "benchmark", "base ns/op", "new ns/op", "delta %", "+/- %", "verdict");
+    for (const auto& cur : current) {
+        auto it = std::find_if(baseline.begin(), baseline.end(), [&](const BenchStats& b) { return b.name == cur.name; });
+        if (it == baseline.end()) {
+            std::printf("%-34s %12s %12.1f %10s %10s  %s\n", cur.name.c_str(), "-", cur.mean, "-", "-", "new");
+            continue;
+        }
+        BenchDelta d = compareBench(*it, cur, thresholdPct);
+        if (d.verdict == BenchVerdict::Regression) regressions++;
+        std::printf("%-34s %12.1f %12.1f %+10.2f %10.2f  %s\n",
+            cur.name.c_str(), it->mean, cur.mean, d.deltaPct, d.ciPct, verdictName(d.verdict));
+    }
+    return regressions;
+}
@@ -0,0 +1,25 @@
+// Env.h
+// Environment variable lookup that builds cleanly under MSVC's /sdl, where
+// std::getenv is a deprecation error (C4996).
+
+#pragma once
+
+#include <cstdlib>
+#include <optional>
+#include <string>
+
+// The variable's value, or nothing when it is not set.
+inline std::optional<std::string> envVar(const char* name) {
+#ifdef _WIN32
+    char* value = nullptr;
+    std::size_t len = 0;
+    if (_dupenv_s(&value, &len, name) != 0 || !value) return std::nullopt;
+    std::string s(value);
+    std::free(value);
+    return s;
+#else
+    const char* value = std::getenv(name);
+    if (!value) return std::nullopt;
+    return std::string(value);
+#endif
+}
@@ -0,0 +1,360 @@
+// FloorLayer.h
+// Textured floor tiles baked into per-chunk render textures.
+//
+// A chunk is CHUNK_TILES x CHUNK_TILES tiles. Its texture is created the first
+// time the chunk is on screen and only re-rendered after one of its tiles
+// changes, so drawing the floor costs one sprite per visible chunk no matter
+// how many tiles the level has.
+//
+// Decals (footprints, scorch marks) are stamped straight into those chunk
+// textures instead of being kept as entities: each frame the queued decals of
+// a chunk go out in one batched draw, and afterwards they cost nothing.
+//
+// The tile ids and the per-chunk tables can come from a level's memory
+// resource. The chunks themselves are created while the level is played and
+// each owns a render texture that SFML allocates itself, so they stay on the
+// heap, as do the decal queues that grow and empty every frame.
+
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+// Procedural stone tiles, 'variants' of them side by side in one atlas row.
+inline sf::Image makeFloorAtlas(unsigned tilePx, int variants) {
+    sf::Image img({ tilePx * static_cast<unsigned>(variants), tilePx }, sf::Color(0, 0, 0));
+    std::uint32_t seed = 0x9E3779B9u;
+    auto rnd = [&]() {
+        seed ^= seed << 13; seed ^= seed >> 17; seed ^= seed << 5;
+        return seed;
+        };
+
+    for (int v = 0; v < variants; ++v) {
+        int base = 26 + v * 3;
+        for (unsigned y = 0; y < tilePx; ++y) {
+            for (unsigned x = 0; x < tilePx; ++x) {
+                int n = static_cast<int>(rnd() % 7) - 3;
+                bool grout = x == 0 || y == 0;
+                int c = grout ? 16 : base + n;
+                img.setPixel({ v * tilePx + x, y }, sf::Color(
+                    static_cast<std::uint8_t>(c),
+                    static_cast<std::uint8_t>(c),
+                    static_cast<std::uint8_t>(c + 6)));
+            }
+        }
+    }
+    return img;
+}
+
+// Decal sprites: one square cell of cellPx per DecalType, side by side in one row.
+enum class DecalType : std::uint8_t { Footprint, Scorch };
+
+inline sf::Image makeDecalAtlas(unsigned cellPx) {
+    sf::Image img({ cellPx * 2, cellPx }, sf::Color::Transparent);
+    float c = (cellPx - 1) / 2.f;
+
+    for (unsigned y = 0; y < cellPx; ++y) {
+        for (unsigned x = 0; x < cellPx; ++x) {
+            float dx = (x - c) / c;
+            float dy = (y - c) / c;
+
+            // Footprint: narrow oval, pointing along +x
+            float foot = (dx * dx) / 0.8f + (dy * dy) / 0.18f;
+            if (foot < 1.f) {
+                img.setPixel({ x, y }, sf::Color(8, 6, 6, static_cast<std::uint8_t>(150 * (1.f - foot * foot))));
+            }
+
+            // Scorch: soft radial burn with a darker core
+            float r = std::sqrt(dx * dx + dy * dy);
+            if (r < 1.f) {
+                float a = 1.f - r;
+                img.setPixel({ cellPx + x, y }, sf::Color(10, 6, 4, static_cast<std::uint8_t>(230 * a * std::sqrt(a))));
+            }
+        }
+    }
+    return img;
+}
+
+struct Decal {
+    DecalType type;
+    sf::Vector2f pos;      // world center
+    float size;            // world-space width/height
+    float rotation = 0.f;  // radians
+};
+
+class FloorLayer {
+public:
+    static constexpr int CHUNK_TILES = 8;
+
+    struct Stats {
+        int chunksDrawn = 0;
+        int chunksRebuilt = 0;   // this frame
+        int chunksResident = 0;  // chunks with a live render texture
+        int decalBatches = 0;    // this frame, one per chunk with new decals
+        long long decalsStamped = 0;
+    };
+
+    FloorLayer() = default;
+    explicit FloorLayer(std::pmr::memory_resource* mem) : tiles(mem), chunks(mem), pendingDecals(mem) {}
+
+    // No tiles, with the storage handed back to the resource.
+    void clear() {
+        cols = rows = chunkCols = chunkRows = 0;
+        std::pmr::vector<std::uint8_t>(tiles.get_allocator()).swap(tiles);
+        std::pmr::vector<std::unique_ptr<Chunk>>(chunks.get_allocator()).swap(chunks);
+        std::pmr::vector<std::vector<Decal>>(pendingDecals.get_allocator()).swap(pendingDecals);
+        hasPendingDecals = false;
+        stats = Stats{};
+    }
+
+    // Atlas holds equally sized tiles in one row; tile id N (1-based) is column N-1.
+    void setAtlas(const sf::Texture* atlas, unsigned tilePx) {
+        atlasTex = atlas;
+        atlasTilePx = tilePx;
+        // A new atlas means a full re-bake, which also drops stamped decals.
+        for (auto& c : chunks) if (c) { c->dirty = true; c->baked = false; }
+    }
+
+    void setDecalAtlas(const sf::Texture* atlas, unsigned cellPx) {
+        decalTex = atlas;
+        decalCellPx = cellPx;
+    }
+
+    void reset(int colsIn, int rowsIn, float tileSizeIn) {
+        cols = colsIn;
+        rows = rowsIn;
+        tileSize = tileSizeIn;
+        tiles.assign(static_cast<std::size_t>(cols) * rows, 0);
+        chunkCols = (cols + CHUNK_TILES - 1) / CHUNK_TILES;
+        chunkRows = (rows + CHUNK_TILES - 1) / CHUNK_TILES;
+        chunks.clear();
+        chunks.resize(static_cast<std::size_t>(chunkCols) * chunkRows);
+        pendingDecals.clear();
+        pendingDecals.resize(chunks.size());
+        hasPendingDecals = false;
+        stats = Stats{};
+    }
+
+    int getCols() const { return cols; }
+    int getRows() const { return rows; }
+    float getTileSize() const { return tileSize; }
+
+    std::uint8_t tile(int x, int y) const {
+        if (x < 0 || y < 0 || x >= cols || y >= rows) return 0;
+        return tiles[static_cast<std::size_t>(y) * cols + x];
+    }
+
+    // Id 0 leaves the cell bare (the clear color shows through).
+    void setTile(int x, int y, std::uint8_t id) {
+        if (x < 0 || y < 0 || x >= cols || y >= rows) return;
+        std::uint8_t& t = tiles[static_cast<std::size_t>(y) * cols + x];
+        if (t == id) return;
+        t = id;
+        if (auto& c = chunks[chunkIndex(x / CHUNK_TILES, y / CHUNK_TILES)]) {
+            c->dirty = true;
+            c->dirtyTiles.push_back({ x % CHUNK_TILES, y % CHUNK_TILES });
+            if (c->dirtyTiles.size() > CHUNK_TILES * CHUNK_TILES) c->baked = false;
+        }
+    }
+
+    // Queue a decal for every chunk it touches; stamped on the next draw().
+    void addDecal(const Decal& d) {
+        if (cols == 0 || rows == 0) return;
+        float chunkWorld = CHUNK_TILES * tileSize;
+        float h = d.size * 0.7072f;   // half-diagonal covers any rotation
+        int cx0 = std::max(0, static_cast<int>(std::floor((d.pos.x - h) / chunkWorld)));
+        int cy0 = std::max(0, static_cast<int>(std::floor((d.pos.y - h) / chunkWorld)));
+        int cx1 = std::min(chunkCols - 1, static_cast<int>(std::floor((d.pos.x + h) / chunkWorld)));
+        int cy1 = std::min(chunkRows - 1, static_cast<int>(std::floor((d.pos.y + h) / chunkWorld)));
+        for (int cy = cy0; cy <= cy1; ++cy) {
+            for (int cx = cx0; cx <= cx1; ++cx) {
+                pendingDecals[chunkIndex(cx, cy)].push_back(d);
+                hasPendingDecals = true;
+            }
+        }
+    }
+
+    void draw(sf::RenderTarget& target, const sf::View& view) {
+        stats.chunksDrawn = 0;
+        stats.chunksRebuilt = 0;
+        stats.decalBatches = 0;
+        if (cols == 0 || rows == 0 || !atlasTex) return;
+
+        if (hasPendingDecals) flushDecals();
+
+        int cx0, cy0, cx1, cy1;
+        visibleChunks(view, cx0, cy0, cx1, cy1);
+        for (int cy = cy0; cy <= cy1; ++cy) {
+            for (int cx = cx0; cx <= cx1; ++cx) {
+                Chunk& c = ensureChunk(cx, cy);
+                if (c.dirty) rebuild(c, cx, cy);
+
+                sf::Sprite spr(c.rt.getTexture());
+                spr.setPosition(chunkOrigin(cx, cy));
+                spr.setScale({ tileSize / atlasTilePx, tileSize / atlasTilePx });
+                target.draw(spr);
+                stats.chunksDrawn++;
+            }
+        }
+    }
+
+    const Stats& getStats() const { return stats; }
+
+    // GPU memory held by chunk render textures.
+    std::size_t residentBytes() const {
+        std::size_t side = static_cast<std::size_t>(CHUNK_TILES) * atlasTilePx;
+        return static_cast<std::size_t>(stats.chunksResident) * side * side * 4;
+    }
+
+private:
+    struct TileCoord { int x, y; };
+
+    struct Chunk {
+        sf::RenderTexture rt;
+        bool dirty = true;
+        bool baked = false;                 // rt holds tiles (and maybe decals) already
+        std::vector<TileCoord> dirtyTiles;  // chunk-local, only meaningful once baked
+    };
+
+    std::size_t chunkIndex(int cx, int cy) const { return static_cast<std::size_t>(cy) * chunkCols + cx; }
+
+    sf::Vector2f chunkOrigin(int cx, int cy) const {
+        return { cx * CHUNK_TILES * tileSize, cy * CHUNK_TILES * tileSize };
+    }
+
+    void visibleChunks(const sf::View& view, int& cx0, int& cy0, int& cx1, int& cy1) const {
+        float chunkWorld = CHUNK_TILES * tileSize;
+        sf::Vector2f lo = view.getCenter() - view.getSize() / 2.f;
+        sf::Vector2f hi = view.getCenter() + view.getSize() / 2.f;
+        cx0 = std::max(0, static_cast<int>(std::floor(lo.x / chunkWorld)));
+        cy0 = std::max(0, static_cast<int>(std::floor(lo.y / chunkWorld)));
+        cx1 = std::min(chunkCols - 1, static_cast<int>(std::floor(hi.x / chunkWorld)));
+        cy1 = std::min(chunkRows - 1, static_cast<int>(std::floor(hi.y / chunkWorld)));
+    }
+
+    Chunk& ensureChunk(int cx, int cy) {
+        auto& slot = chunks[chunkIndex(cx, cy)];
+        if (!slot) {
+            slot = std::make_unique<Chunk>();
+            unsigned px = CHUNK_TILES * atlasTilePx;
+            if (!slot->rt.resize({ px, px })) {
+                std::cout << "Failed to create floor chunk texture.\n";
+            }
+            stats.chunksResident++;
+        }
+        return *slot;
+    }
+
+    void appendTileQuad(sf::VertexArray& quads, int tx, int ty, std::uint8_t id) const {
+        float px = static_cast<float>(atlasTilePx);
+        float x0 = tx * px, y0 = ty * px;
+        float u0 = (id - 1) * px;
+        sf::Color col = id == 0 ? sf::Color::Transparent : sf::Color::White;
+        if (id == 0) u0 = 0.f;
+
+        sf::Vertex v[4] = {
+            { { x0, y0 },           col, { u0, 0.f } },
+            { { x0 + px, y0 },      col, { u0 + px, 0.f } },
+            { { x0 + px, y0 + px }, col, { u0 + px, px } },
+            { { x0, y0 + px },      col, { u0, px } },
+        };
+        quads.append(v[0]); quads.append(v[1]); quads.append(v[2]);
+        quads.append(v[0]); quads.append(v[2]); quads.append(v[3]);
+    }
+
+    // Bake the chunk's tiles at atlas resolution (one draw call per chunk).
+    // Once baked, only tiles that changed are redrawn so stamped decals on
+    // the rest of the chunk survive.
+    void rebuild(Chunk& c, int cx, int cy) {
+        sf::VertexArray quads(sf::PrimitiveType::Triangles);
+        if (!c.baked) {
+            for (int ty = 0; ty < CHUNK_TILES; ++ty) {
+                for (int tx = 0; tx < CHUNK_TILES; ++tx) {
+                    std::uint8_t id = tile(cx * CHUNK_TILES + tx, cy * CHUNK_TILES + ty);
+                    if (id != 0) appendTileQuad(quads, tx, ty, id);
+                }
+            }
+            c.rt.clear(sf::Color::Transparent);
+            c.rt.draw(quads, sf::RenderStates(atlasTex));
+        }
+        else {
+            for (const auto& t : c.dirtyTiles) {
+                appendTileQuad(quads, t.x, t.y, tile(cx * CHUNK_TILES + t.x, cy * CHUNK_TILES + t.y));
+            }
+            sf::RenderStates states(atlasTex);
+            states.blendMode = sf::BlendNone;
+            c.rt.draw(quads, states);
+        }
+
+        c.rt.display();
+        c.dirty = false;
+        c.baked = true;
+        c.dirtyTiles.clear();
+        stats.chunksRebuilt++;
+    }
+
+    // One draw per chunk with queued decals, in chunk-texture pixels.
+    void flushDecals() {
+        hasPendingDecals = false;
+        if (!decalTex) {
+            for (auto& p : pendingDecals) p.clear();
+            return;
+        }
+
+        float toPx = atlasTilePx / tileSize;
+        float cell = static_cast<float>(decalCellPx);
+        for (int cy = 0; cy < chunkRows; ++cy) {
+            for (int cx = 0; cx < chunkCols; ++cx) {
+                auto& pending = pendingDecals[chunkIndex(cx, cy)];
+                if (pending.empty()) continue;
+
+                Chunk& c = ensureChunk(cx, cy);
+                if (c.dirty) rebuild(c, cx, cy);
+
+                sf::Vector2f org = chunkOrigin(cx, cy);
+                sf::VertexArray quads(sf::PrimitiveType::Triangles);
+                for (const Decal& d : pending) {
+                    sf::Vector2f center = (d.pos - org) * toPx;
+                    float h = d.size * toPx / 2.f;
+                    sf::Vector2f ax = { std::cos(d.rotation) * h, std::sin(d.rotation) * h };
+                    sf::Vector2f ay = { -ax.y, ax.x };
+                    float u0 = static_cast<float>(d.type) * cell;
+
+                    sf::Vertex v[4] = {
+                        { center - ax - ay, sf::Color::White, { u0, 0.f } },
+                        { center + ax - ay, sf::Color::White, { u0 + cell, 0.f } },
+                        { center + ax + ay, sf::Color::White, { u0 + cell, cell } },
+                        { center - ax + ay, sf::Color::White, { u0, cell } },
+                    };
+                    quads.append(v[0]); quads.append(v[1]); quads.append(v[2]);
+                    quads.append(v[0]); quads.append(v[2]); quads.append(v[3]);
+                }
+
+                c.rt.draw(quads, sf::RenderStates(decalTex));
+                c.rt.display();
+                stats.decalsStamped += static_cast<long long>(pending.size());
+                stats.decalBatches++;
+                pending.clear();
+            }
+        }
+    }
+
+    const sf::Texture* atlasTex = nullptr;
+    unsigned atlasTilePx = 1;
+    const sf::Texture* decalTex = nullptr;
+    unsigned decalCellPx = 1;
+    int cols = 0, rows = 0;
+    float tileSize = 1.f;
+    int chunkCols = 0, chunkRows = 0;
+    std::pmr::vector<std::uint8_t> tiles;
+    std::pmr::vector<std::unique_ptr<Chunk>> chunks;
+    std::pmr::vector<std::vector<Decal>> pendingDecals;   // per chunk, emptied every draw()
+    bool hasPendingDecals = false;
+    Stats stats;
+};
@@ -0,0 +1,193 @@
+// Geometry.h
+// Small 2D geometry helpers shared by the game and the level modules.
+
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+struct RectF { float x, y, w, h; };
+
+struct Segment { sf::Vector2f a, b; };
+
+inline sf::Vector2f normalize(sf::Vector2f v) {
+    float len = std::sqrt(v.x * v.x + v.y * v.y);
+    if (len == 0.f) return { 0.f, 0.f };
+    return { v.x / len, v.y / len };
+}
+
+inline bool circleIntersectsRect(const sf::Vector2f& c, float r, const sf::FloatRect& rect) {
+    float left = rect.position.x;
+    float top = rect.position.y;
+    float right = rect.position.x + rect.size.x;
+    float bottom = rect.position.y + rect.size.y;
+
+    float closestX = std::max(left, std::min(c.x, right));
+    float closestY = std::max(top, std::min(c.y, bottom));
+
+    float dx = c.x - closestX;
+    float dy = c.y - closestY;
+    return (dx * dx + dy * dy) < (r * r);
+}
+
+inline bool circleIntersectsCircle(sf::Vector2f a, float ra, sf::Vector2f b, float rb) {
+    sf::Vector2f d = a - b;
+    float dist2 = d.x * d.x + d.y * d.y;
+    float r = ra + rb;
+    return dist2 < (r * r);
+}
+
+inline float cross2(const sf::Vector2f& a, const sf::Vector2f& b) {
+    return a.x * b.y - a.y * b.x;
+}
+
+inline bool raySegmentIntersect(
+    const sf::Vector2f& p, const sf::Vector2f& r,
+    const sf::Vector2f& q, const sf::Vector2f& s,
+    float& tHit, sf::Vector2f& hitPoint
+) {
+    float rxs = cross2(r, s);
+    if (std::fabs(rxs) < 1e-8f) return false;
+
+    sf::Vector2f qmp = { q.x - p.x, q.y - p.y };
+    float t = cross2(qmp, s) / rxs;
+    float u = cross2(qmp, r) / rxs;
+
+    if (t >= 0.f && u >= 0.f && u <= 1.f) {
+        tHit = t;
+        hitPoint = { p.x + t * r.x, p.y + t * r.y };
+        return true;
+    }
+    return false;
+}
+
+// Squared distance from p to segment ab.
+inline float pointSegmentDistanceSq(const sf::Vector2f& p, const sf::Vector2f& a, const sf::Vector2f& b) {
+    sf::Vector2f ab = b - a, ap = p - a;
+    float len2 = ab.x * ab.x + ab.y * ab.y;
+    float t = len2 > 0.f ? std::clamp((ap.x * ab.x + ap.y * ab.y) / len2, 0.f, 1.f) : 0.f;
+    sf::Vector2f d = ap - ab * t;
+    return d.x * d.x + d.y * d.y;
+}
+
+// Squared distance between segments ab and cd; 0 when they cross.
+inline float segmentDistanceSq(const sf::Vector2f& a, const sf::Vector2f& b, const sf::Vector2f& c, const sf::Vector2f& d) {
+    float d1 = cross2(b - a, c - a), d2 = cross2(b - a, d - a);
+    float d3 = cross2(d - c, a - c), d4 = cross2(d - c, b - c);
+    if (((d1 > 0.f && d2 < 0.f) || (d1 < 0.f && d2 > 0.f)) && ((d3 > 0.f && d4 < 0.f) || (d3 < 0.f && d4 > 0.f))) return 0.f;
+    return std::min({ pointSegmentDistanceSq(a, c, d), pointSegmentDistanceSq(b, c, d),
+                      pointSegmentDistanceSq(c, a, b), pointSegmentDistanceSq(d, a, b) });
+}
+
+// ---------------- Convex polygons and circles ----------------
+struct ConvexPoly { std::vector<sf::Vector2f> pts; };   // either winding, must be convex
+
+struct CircleObstacle { sf::Vector2f c; float r; };
+
+inline ConvexPoly makeRegularPoly(sf::Vector2f center, float radius, int sides, float rotation = 0.f) {
+    ConvexPoly p;
+    p.pts.reserve(sides);
+    for (int i = 0; i < sides; ++i) {
+        float a = rotation + 2.f * 3.14159265f * static_cast<float>(i) / static_cast<float>(sides);
+        p.pts.push_back({ center.x + std::cos(a) * radius, center.y + std::sin(a) * radius });
+    }
+    return p;
+}
+
+inline sf::FloatRect polyBounds(const ConvexPoly& p) {
+    if (p.pts.empty()) return {};
+    sf::Vector2f lo = p.pts[0], hi = p.pts[0];
+    for (const auto& v : p.pts) {
+        lo = { std::min(lo.x, v.x), std::min(lo.y, v.y) };
+        hi = { std::max(hi.x, v.x), std::max(hi.y, v.y) };
+    }
+    return { lo, hi - lo };
+}
+
+// Separating axis test: the polygon's edge normals plus the axis towards the
+// nearest vertex (the only extra axis a circle can be separated on).
+// Touching counts as not intersecting, like circleIntersectsRect.
+inline bool circleIntersectsPoly(const sf::Vector2f& c, float r, const ConvexPoly& poly) {
+    const std::size_t n = poly.pts.size();
+    if (n < 3) return false;
+
+    auto separated = [&](sf::Vector2f axis) {
+        axis = normalize(axis);
+        if (axis.x == 0.f && axis.y == 0.f) return false;
+        float lo = std::numeric_limits<float>::infinity();
+        float hi = -lo;
+        for (const auto& v : poly.pts) {
+            float d = v.x * axis.x + v.y * axis.y;
+            lo = std::min(lo, d);
+            hi = std::max(hi, d);
+        }
+        float cd = c.x * axis.x + c.y * axis.y;
+        return hi <= cd - r || lo >= cd + r;
+        };
+
+    float bestD2 = std::numeric_limits<float>::infinity();
+    sf::Vector2f nearest = poly.pts[0];
+    for (std::size_t i = 0; i < n; ++i) {
+        const sf::Vector2f& a = poly.pts[i];
+        const sf::Vector2f& b = poly.pts[(i + 1) % n];
+        if (separated({ -(b.y - a.y), b.x - a.x })) return false;
+
+        sf::Vector2f d = a - c;
+        float d2 = d.x * d.x + d.y * d.y;
+        if (d2 < bestD2) { bestD2 = d2; nearest = a; }
+    }
+    return !separated(nearest - c);
+}
+
+// Ray p + t*dir (dir unit length) against a circle; nearest t >= 0 on entry.
+inline bool rayCircleIntersect(const sf::Vector2f& p, const sf::Vector2f& dir, const CircleObstacle& circle, float& tHit) {
+    sf::Vector2f m = p - circle.c;
+    float b = m.x * dir.x + m.y * dir.y;
+    float c = m.x * m.x + m.y * m.y - circle.r * circle.r;
+    if (c > 0.f && b > 0.f) return false;
+
+    float disc = b * b - c;
+    if (disc < 0.f) return false;
+
+    float t = -b - std::sqrt(disc);
+    if (t < 0.f) return false;
+    tHit = t;
+    return true;
+}
+
+// ---------------- Space-filling curve ----------------
+// Z-order (Morton) key of p inside [lo, hi], 16 bits per axis. Sorting by it
+// puts things that are close in space close in memory.
+inline std::uint32_t mortonKey(sf::Vector2f p, sf::Vector2f lo, sf::Vector2f hi) {
+    auto cell = [](float v, float a, float b) -> std::uint32_t {
+        float t = b > a ? (v - a) / (b - a) : 0.f;
+        return static_cast<std::uint32_t>(std::clamp(t, 0.f, 1.f) * 65535.f);
+        };
+    auto spread = [](std::uint32_t v) {
+        v = (v | (v << 8)) & 0x00FF00FFu;
+        v = (v | (v << 4)) & 0x0F0F0F0Fu;
+        v = (v | (v << 2)) & 0x33333333u;
+        v = (v | (v << 1)) & 0x55555555u;
+        return v;
+        };
+    return spread(cell(p.x, lo.x, hi.x)) | (spread(cell(p.y, lo.y, hi.y)) << 1);
+}
+
+// Stable reorder of 'items' (a std::vector or std::pmr::vector) along the Z
+// curve; pos(item) gives its location. The result is moved back into the
+// same storage, so an arena-backed array doesn't grow a second copy.
+template <typename Vec, typename F>
+void sortByMorton(Vec& items, sf::Vector2f lo, sf::Vector2f hi, F&& pos) {
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> keys(items.size());
+    for (std::size_t i = 0; i < items.size(); ++i) keys[i] = { mortonKey(pos(items[i]), lo, hi), static_cast<std::uint32_t>(i) };
+    std::stable_sort(keys.begin(), keys.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    std::vector<typename Vec::value_type> sorted;
+    sorted.reserve(items.size());
+    for (const auto& k : keys) sorted.push_back(std::move(items[k.second]));
+    std::move(sorted.begin(), sorted.end(), items.begin());
+}
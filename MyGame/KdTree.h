@@ -0,0 +1,152 @@
+// KdTree.h
+// Static 2D k-d tree over point ids, for nearest-target queries every frame.
+//
+// Built once at level load into an implicit, array-laid-out tree (the median
+// of each range is its node). Removal only sets a tombstone; once dead
+// entries outnumber live ones the tree is rebuilt from the survivors so
+// queries never wade through mostly-dead subtrees. The arrays can come from
+// a level's memory resource; a rebuild reuses their storage.
+
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory_resource>
+#include <vector>
+
+class KdTree2 {
+public:
+    static constexpr std::size_t MIN_REBUILD_DEAD = 32;
+
+    KdTree2() = default;
+    explicit KdTree2(std::pmr::memory_resource* mem) : pos(mem), alive(mem), nodes(mem) {}
+
+    // 'points' is a std::vector or std::pmr::vector of positions, by id.
+    template <typename Points>
+    void build(const Points& points) {
+        pos.assign(points.begin(), points.end());
+        alive.assign(points.size(), 1);
+        liveCount = points.size();
+        rebuildFromAlive();
+    }
+
+    // Empty, with the storage handed back to the resource.
+    void clear() {
+        std::pmr::vector<sf::Vector2f>(pos.get_allocator()).swap(pos);
+        std::pmr::vector<std::uint8_t>(alive.get_allocator()).swap(alive);
+        std::pmr::vector<Node>(nodes.get_allocator()).swap(nodes);
+        liveCount = 0;
+        deadInTree = 0;
+    }
+
+    std::size_t size() const { return liveCount; }
+    bool isAlive(std::uint32_t id) const { return id < alive.size() && alive[id]; }
+    const sf::Vector2f& point(std::uint32_t id) const { return pos[id]; }
+
+    // Tombstone one id. Returns false if it was already gone.
+    bool remove(std::uint32_t id) {
+        if (!isAlive(id)) return false;
+        alive[id] = 0;
+        liveCount--;
+        deadInTree++;
+        if (deadInTree >= MIN_REBUILD_DEAD && deadInTree > liveCount) rebuildFromAlive();
+        return true;
+    }
+
+    // Closest live id to q, or -1 if none. dist2 receives the squared distance.
+    int nearest(sf::Vector2f q, float* dist2 = nullptr) const {
+        int best = -1;
+        float bestD2 = std::numeric_limits<float>::infinity();
+        if (!nodes.empty()) search(0, static_cast<int>(nodes.size()), q, best, bestD2);
+        if (dist2) *dist2 = bestD2;
+        return best;
+    }
+
+    // Every live id within radius r of q. 'visit' must not remove ids (collect, then remove).
+    template <typename F>
+    void forEachWithin(sf::Vector2f q, float r, F&& visit) const {
+        if (!nodes.empty()) within(0, static_cast<int>(nodes.size()), q, r, r * r, visit);
+    }
+
+private:
+    struct Node {
+        sf::Vector2f p;
+        std::uint32_t id;
+        std::uint8_t axis;   // 0 = split on x, 1 = split on y
+    };
+
+    void rebuildFromAlive() {
+        nodes.clear();
+        nodes.reserve(liveCount);
+        for (std::uint32_t i = 0; i < pos.size(); ++i) {
+            if (alive[i]) nodes.push_back({ pos[i], i, 0 });
+        }
+        deadInTree = 0;
+        buildRange(0, static_cast<int>(nodes.size()));
+    }
+
+    void buildRange(int lo, int hi) {
+        if (hi - lo <= 0) return;
+        float minX = std::numeric_limits<float>::infinity(), maxX = -minX;
+        float minY = minX, maxY = -minX;
+        for (int i = lo; i < hi; ++i) {
+            minX = std::min(minX, nodes[i].p.x); maxX = std::max(maxX, nodes[i].p.x);
+            minY = std::min(minY, nodes[i].p.y); maxY = std::max(maxY, nodes[i].p.y);
+        }
+        std::uint8_t axis = (maxX - minX) >= (maxY - minY) ? 0 : 1;
+
+        int mid = lo + (hi - lo) / 2;
+        std::nth_element(nodes.begin() + lo, nodes.begin() + mid, nodes.begin() + hi, [axis](const Node& a, const Node& b) {
+            return axis == 0 ? a.p.x < b.p.x : a.p.y < b.p.y;
+            });
+        nodes[mid].axis = axis;
+        buildRange(lo, mid);
+        buildRange(mid + 1, hi);
+    }
+
+    void search(int lo, int hi, sf::Vector2f q, int& best, float& bestD2) const {
+        if (hi - lo <= 0) return;
+        int mid = lo + (hi - lo) / 2;
+        const Node& n = nodes[mid];
+
+        if (alive[n.id]) {
+            sf::Vector2f d = n.p - q;
+            float d2 = d.x * d.x + d.y * d.y;
+            if (d2 < bestD2) { bestD2 = d2; best = static_cast<int>(n.id); }
+        }
+
+        float diff = n.axis == 0 ? q.x - n.p.x : q.y - n.p.y;
+        if (diff < 0.f) {
+            search(lo, mid, q, best, bestD2);
+            if (diff * diff < bestD2) search(mid + 1, hi, q, best, bestD2);
+        }
+        else {
+            search(mid + 1, hi, q, best, bestD2);
+            if (diff * diff < bestD2) search(lo, mid, q, best, bestD2);
+        }
+    }
+
+    template <typename F>
+    void within(int lo, int hi, sf::Vector2f q, float r, float r2, F& visit) const {
+        if (hi - lo <= 0) return;
+        int mid = lo + (hi - lo) / 2;
+        const Node& n = nodes[mid];
+
+        if (alive[n.id]) {
+            sf::Vector2f d = n.p - q;
+            if (d.x * d.x + d.y * d.y <= r2) visit(n.id);
+        }
+
+        float diff = n.axis == 0 ? q.x - n.p.x : q.y - n.p.y;
+        if (diff - r <= 0.f) within(lo, mid, q, r, r2, visit);
+        if (diff + r >= 0.f) within(mid + 1, hi, q, r, r2, visit);
+    }
+
+    std::pmr::vector<sf::Vector2f> pos;       // by id
+    std::pmr::vector<std::uint8_t> alive;     // by id
+    std::pmr::vector<Node> nodes;             // implicit tree
+    std::size_t liveCount = 0;
+    std::size_t deadInTree = 0;
+};
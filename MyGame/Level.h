@@ -0,0 +1,36 @@
+// Level.h
+// Level description shared by the game, the level file codec and tools.
+// Plain data only; building geometry and drawables from it happens elsewhere.
+
+#pragma once
+
+#include "Geometry.h"
+#include <string>
+#include <vector>
+
+enum class PowerType { AddTime, Speed, Arrow, FullLight };
+
+struct PowerUp {
+    PowerType type;
+    sf::Vector2f pos;
+    bool active = true;
+};
+
+struct LevelDef {
+    std::string name;
+    float worldW;
+    float worldH;
+    sf::Vector2f playerSpawn;
+    std::vector<sf::Vector2f> targetSpawns;   // collect every one to clear the level
+    float timeLimit = 30.f;
+    std::vector<RectF> wallRects;
+    std::vector<PowerUp> powerups;
+
+    // Optional tile-painted walls ('#' = solid), one string per row of tileSize cells
+    float tileSize = 0.f;
+    std::vector<std::string> tileRows;
+
+    // Optional non-rectangular obstacles
+    std::vector<ConvexPoly> polygons;
+    std::vector<CircleObstacle> circles;
+};
@@ -0,0 +1,138 @@
+// LevelArena.h
+// One memory block for everything that lives exactly as long as a level.
+//
+// The level's containers (shape arrays, edges, BVH, grid bits, path graph,
+// the drawables list) take the arena as their std::pmr resource. It hands out
+// memory by bumping a pointer and never frees piecemeal; unloading a level
+// drops the containers' storage and calls release(), which rewinds the block
+// in one go. Hundreds of level switches therefore leave no fragmentation
+// behind, and used() is the level's footprint to the byte. The block is
+// reserved once up front, optionally on huge pages; a level that outgrows it
+// spills into heap chunks, which release() frees as well.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <memory_resource>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+class LevelArena : public std::pmr::memory_resource {
+public:
+    static constexpr std::size_t DEFAULT_BYTES = 32u << 20;   // comfortably above the authored levels
+    static constexpr std::size_t HUGE_PAGE = 2u << 20;
+
+    explicit LevelArena(std::size_t bytes = DEFAULT_BYTES, bool hugePages = false)
+        : blockBytes(bytes), block(reserve(blockBytes, hugePages, huge)),
+          bump(block, blockBytes, std::pmr::new_delete_resource()) {}
+
+    ~LevelArena() override {
+        bump.release();
+        unreserve(block, blockBytes);
+    }
+
+    LevelArena(const LevelArena&) = delete;
+    LevelArena& operator=(const LevelArena&) = delete;
+
+    // Rewind to an empty block. Every container using the arena must have
+    // dropped its storage first (see dropStorage).
+    void release() {
+        bump.release();
+        usedBytes = 0;
+        allocations = 0;
+    }
+
+    std::size_t used() const { return usedBytes; }          // bytes handed out since the last release
+    std::size_t peak() const { return peakBytes; }          // most used() has ever been
+    std::size_t count() const { return allocations; }
+    std::size_t capacity() const { return blockBytes; }     // beyond this, allocations spill to the heap
+    bool hugePages() const { return huge; }
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t align) override {
+        void* p = bump.allocate(bytes, align);
+        usedBytes += bytes;
+        allocations++;
+        peakBytes = std::max(peakBytes, usedBytes);
+        return p;
+    }
+
+    void do_deallocate(void*, std::size_t, std::size_t) override {}
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    // Huge pages need the size rounded up to whole pages and, on Windows, the
+    // "Lock pages in memory" privilege; without them the block uses normal pages.
+    static void* reserve(std::size_t& bytes, bool wantHuge, bool& gotHuge) {
+        gotHuge = false;
+        if (bytes == 0) return nullptr;
+        void* p = nullptr;
+#ifdef _WIN32
+        if (wantHuge) {
+            std::size_t page = GetLargePageMinimum();
+            if (page > 0) {
+                std::size_t rounded = (bytes + page - 1) / page * page;
+                p = VirtualAlloc(nullptr, rounded, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+                if (p) { bytes = rounded; gotHuge = true; return p; }
+            }
+        }
+        p = VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+        if (wantHuge) {
+#ifdef MAP_HUGETLB
+            std::size_t rounded = (bytes + HUGE_PAGE - 1) / HUGE_PAGE * HUGE_PAGE;
+            p = mmap(nullptr, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (p != MAP_FAILED) { bytes = rounded; gotHuge = true; return p; }
+#endif
+        }
+        p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) p = nullptr;
+#ifdef MADV_HUGEPAGE
+        if (p && wantHuge) madvise(p, bytes, MADV_HUGEPAGE);   // transparent huge pages, if the kernel allows
+#endif
+#endif
+        if (wantHuge && !gotHuge) std::cout << "Level arena: huge pages unavailable; using normal pages.\n";
+        if (!p) {
+            std::cout << "Level arena: could not reserve " << (bytes >> 20) << " MiB; level data goes to the heap.\n";
+            bytes = 0;
+        }
+        return p;
+    }
+
+    static void unreserve(void* p, std::size_t bytes) {
+        if (!p) return;
+#ifdef _WIN32
+        (void)bytes;
+        VirtualFree(p, 0, MEM_RELEASE);
+#else
+        munmap(p, bytes);
+#endif
+    }
+
+    std::size_t blockBytes;
+    bool huge = false;
+    void* block;
+    std::pmr::monotonic_buffer_resource bump;
+    std::size_t usedBytes = 0;
+    std::size_t peakBytes = 0;
+    std::size_t allocations = 0;
+};
+
+// Free a container's storage back to its resource, keeping the resource.
+// (Assigning or clearing keeps the capacity, which must not outlive a release.)
+template <typename Container>
+void dropStorage(Container& c) {
+    Container(c.get_allocator()).swap(c);
+}
@@ -0,0 +1,511 @@
+// LevelFile.h
+// Binary level format (.mglv) with per-chunk compression.
+//
+// The world is cut into CHUNK_WORLD x CHUNK_WORLD chunks. Every object is
+// stored in exactly one chunk (the one holding its anchor point) and the
+// tiles of a chunk are the ones whose centers fall inside it. Within a chunk
+// each field is its own integer column (all rect x's, then all y's, ...),
+// coordinates in 1/256 world-unit fixed point. A column is delta + zigzag
+// coded and bit-packed in blocks of 128 with one width byte per block, so
+// grid-aligned walls cost a few bits each.
+//
+// Loading reads the file in one go, checks the checksum, sizes every output
+// array from the chunk directory, then worker threads decode chunks straight
+// into their slices. The column codec has no redundancy of its own (a flipped
+// bit is usually just a different wall), so the checksum is what turns a
+// damaged file into an error rather than a different level.
+//
+// Layout (little endian):
+//   'MGLV' u32 version
+//   u64 checksum (FNV-1a of every byte after it)
+//   u16 nameLen, name bytes
+//   f32 worldW worldH spawnX spawnY timeLimit tileSize
+//   u32 tileCols tileRows chunkCols chunkRows
+//   chunkCols*chunkRows x ChunkDir
+//   chunk payloads
+
+#pragma once
+
+#include "Level.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace levelfile {
+
+    constexpr std::uint32_t MAGIC = 0x564C474Du;   // "MGLV"
+    constexpr std::uint32_t VERSION = 2;
+    constexpr float CHUNK_WORLD = 1024.f;
+    constexpr float FIXED_ONE = 256.f;
+    constexpr std::size_t BLOCK = 128;
+    constexpr float MAX_WORLD = 1.0e6f;
+    constexpr std::uint64_t MAX_TILES = 1ull << 26;
+    constexpr std::uint64_t MAX_FILE_BYTES = 1ull << 32;   // chunk offsets are u32
+
+    enum Count { Rects, Polys, PolyPts, Circles, Targets, Powerups, TileRuns, COUNT_KINDS };
+
+    struct ChunkDir {
+        std::uint32_t offset;
+        std::uint32_t bytes;
+        std::uint32_t counts[COUNT_KINDS];
+    };
+
+    inline std::int32_t toFixed(float v) { return static_cast<std::int32_t>(std::lround(v * FIXED_ONE)); }
+    inline float fromFixed(std::int32_t v) { return static_cast<float>(v) / FIXED_ONE; }
+
+    // ---------------- Integer column codec ----------------
+
+    inline std::uint32_t zigzag(std::int32_t v) { return (static_cast<std::uint32_t>(v) << 1) ^ static_cast<std::uint32_t>(v >> 31); }
+    inline std::int32_t unzigzag(std::uint32_t v) { return static_cast<std::int32_t>(v >> 1) ^ -static_cast<std::int32_t>(v & 1u); }
+
+    inline void encodeColumn(const std::vector<std::int32_t>& values, std::vector<std::uint8_t>& out) {
+        std::int32_t prev = 0;
+        std::uint32_t zz[BLOCK];
+        for (std::size_t base = 0; base < values.size(); base += BLOCK) {
+            std::size_t n = std::min(BLOCK, values.size() - base);
+            std::uint32_t all = 0;
+            for (std::size_t i = 0; i < n; ++i) {
+                std::int32_t v = values[base + i];
+                zz[i] = zigzag(static_cast<std::int32_t>(static_cast<std::uint32_t>(v) - static_cast<std::uint32_t>(prev)));
+                prev = v;
+                all |= zz[i];
+            }
+            int width = 0;
+            while (width < 32 && (all >> width) != 0) ++width;
+            out.push_back(static_cast<std::uint8_t>(width));
+
+            std::uint64_t acc = 0;
+            int bits = 0;
+            for (std::size_t i = 0; i < n; ++i) {
+                acc |= static_cast<std::uint64_t>(zz[i]) << bits;
+                bits += width;
+                while (bits >= 8) {
+                    out.push_back(static_cast<std::uint8_t>(acc));
+                    acc >>= 8;
+                    bits -= 8;
+                }
+            }
+            if (bits > 0) out.push_back(static_cast<std::uint8_t>(acc));
+        }
+    }
+
+    // Decodes 'count' values into dst. Returns false on truncated or corrupt input.
+    inline bool decodeColumn(const std::uint8_t*& p, const std::uint8_t* end, std::int32_t* dst, std::size_t count) {
+        std::int32_t prev = 0;
+        for (std::size_t base = 0; base < count; base += BLOCK) {
+            std::size_t n = std::min(BLOCK, count - base);
+            if (p >= end) return false;
+            int width = *p++;
+            if (width > 32) return false;
+
+            std::size_t bytes = (n * static_cast<std::size_t>(width) + 7) / 8;
+            if (static_cast<std::size_t>(end - p) < bytes) return false;
+
+            std::uint64_t acc = 0;
+            int bits = 0;
+            std::uint64_t mask = width == 32 ? 0xFFFFFFFFull : ((1ull << width) - 1);
+            for (std::size_t i = 0; i < n; ++i) {
+                while (bits < width) {
+                    acc |= static_cast<std::uint64_t>(*p++) << bits;
+                    bits += 8;
+                }
+                std::uint32_t zz = static_cast<std::uint32_t>(acc & mask);
+                acc = width == 32 ? acc >> 32 : acc >> width;
+                bits -= width;
+                prev = static_cast<std::int32_t>(static_cast<std::uint32_t>(prev) + static_cast<std::uint32_t>(unzigzag(zz)));
+                dst[base + i] = prev;
+            }
+        }
+        return true;
+    }
+
+    // ---------------- Chunk geometry ----------------
+
+    struct ChunkGrid {
+        int cols = 1, rows = 1;
+
+        ChunkGrid() = default;
+        ChunkGrid(float worldW, float worldH)
+            : cols(std::max(1, static_cast<int>(std::ceil(worldW / CHUNK_WORLD)))),
+              rows(std::max(1, static_cast<int>(std::ceil(worldH / CHUNK_WORLD)))) {}
+
+        int indexOf(sf::Vector2f p) const {
+            int cx = std::clamp(static_cast<int>(std::floor(p.x / CHUNK_WORLD)), 0, cols - 1);
+            int cy = std::clamp(static_cast<int>(std::floor(p.y / CHUNK_WORLD)), 0, rows - 1);
+            return cy * cols + cx;
+        }
+    };
+
+    // Tiles [first, last) along one axis whose centers land in chunk c.
+    inline void tileSpan(int c, int chunkCount, int tileCount, float tileSize, int& first, int& last) {
+        auto chunkOfTile = [&](int i) {
+            return std::clamp(static_cast<int>(std::floor((i + 0.5f) * tileSize / CHUNK_WORLD)), 0, chunkCount - 1);
+            };
+        first = 0;
+        while (first < tileCount && chunkOfTile(first) < c) ++first;
+        last = first;
+        while (last < tileCount && chunkOfTile(last) == c) ++last;
+    }
+
+    inline sf::Vector2f polyAnchor(const ConvexPoly& p) {
+        sf::FloatRect b = polyBounds(p);
+        return b.position + b.size / 2.f;
+    }
+
+    // ---------------- Byte helpers ----------------
+
+    template <typename T>
+    void put(std::vector<std::uint8_t>& out, const T& v) {
+        std::uint8_t raw[sizeof(T)];
+        std::memcpy(raw, &v, sizeof(T));
+        out.insert(out.end(), raw, raw + sizeof(T));
+    }
+
+    template <typename T>
+    bool get(const std::uint8_t*& p, const std::uint8_t* end, T& v) {
+        if (static_cast<std::size_t>(end - p) < sizeof(T)) return false;
+        std::memcpy(&v, p, sizeof(T));
+        p += sizeof(T);
+        return true;
+    }
+
+    inline std::uint64_t checksum(const std::uint8_t* p, const std::uint8_t* end) {
+        std::uint64_t h = 0xCBF29CE484222325ull;
+        for (; p != end; ++p) { h ^= *p; h *= 0x100000001B3ull; }
+        return h;
+    }
+
+    inline int tileColsOf(const LevelDef& L) {
+        std::size_t cols = 0;
+        for (const auto& r : L.tileRows) cols = std::max(cols, r.size());
+        return static_cast<int>(cols);
+    }
+
+    // ---------------- Encode ----------------
+
+    inline std::vector<std::uint8_t> encodeChunk(const LevelDef& L, const ChunkGrid& grid, int chunk, ChunkDir& dir) {
+        std::vector<std::int32_t> c[3];
+        std::vector<std::uint8_t> out;
+        auto flush = [&](std::vector<std::int32_t>& col) { encodeColumn(col, out); col.clear(); };
+        std::memset(dir.counts, 0, sizeof(dir.counts));
+
+        // Walls, sorted so neighbouring rows/columns delta well. Sorting on
+        // the stored fixed-point values keeps a loaded level saving to the
+        // same bytes.
+        auto fixedLess = [](float ay, float ax, float by, float bx) {
+            std::int32_t fa = toFixed(ay), fb = toFixed(by);
+            return fa != fb ? fa < fb : toFixed(ax) < toFixed(bx);
+            };
+        std::vector<RectF> rects;
+        for (const auto& r : L.wallRects) if (grid.indexOf({ r.x, r.y }) == chunk) rects.push_back(r);
+        std::stable_sort(rects.begin(), rects.end(), [&](const RectF& a, const RectF& b) { return fixedLess(a.y, a.x, b.y, b.x); });
+        dir.counts[Rects] = static_cast<std::uint32_t>(rects.size());
+        std::vector<std::int32_t> w, h;
+        for (const auto& r : rects) {
+            c[0].push_back(toFixed(r.x)); c[1].push_back(toFixed(r.y));
+            w.push_back(toFixed(r.w)); h.push_back(toFixed(r.h));
+        }
+        flush(c[0]); flush(c[1]); flush(w); flush(h);
+
+        // Polygons: vertex counts, then all x's and y's
+        for (const auto& p : L.polygons) {
+            if (grid.indexOf(polyAnchor(p)) != chunk) continue;
+            dir.counts[Polys]++;
+            dir.counts[PolyPts] += static_cast<std::uint32_t>(p.pts.size());
+            c[2].push_back(static_cast<std::int32_t>(p.pts.size()));
+            for (const auto& v : p.pts) { c[0].push_back(toFixed(v.x)); c[1].push_back(toFixed(v.y)); }
+        }
+        flush(c[2]); flush(c[0]); flush(c[1]);
+
+        for (const auto& ci : L.circles) {
+            if (grid.indexOf(ci.c) != chunk) continue;
+            dir.counts[Circles]++;
+            c[0].push_back(toFixed(ci.c.x)); c[1].push_back(toFixed(ci.c.y)); c[2].push_back(toFixed(ci.r));
+        }
+        flush(c[0]); flush(c[1]); flush(c[2]);
+
+        std::vector<sf::Vector2f> targets;
+        for (const auto& t : L.targetSpawns) if (grid.indexOf(t) == chunk) targets.push_back(t);
+        std::stable_sort(targets.begin(), targets.end(), [&](sf::Vector2f a, sf::Vector2f b) { return fixedLess(a.y, a.x, b.y, b.x); });
+        dir.counts[Targets] = static_cast<std::uint32_t>(targets.size());
+        for (const auto& t : targets) { c[0].push_back(toFixed(t.x)); c[1].push_back(toFixed(t.y)); }
+        flush(c[0]); flush(c[1]);
+
+        for (const auto& pw : L.powerups) {
+            if (grid.indexOf(pw.pos) != chunk) continue;
+            dir.counts[Powerups]++;
+            c[2].push_back(static_cast<std::int32_t>(pw.type));
+            c[0].push_back(toFixed(pw.pos.x)); c[1].push_back(toFixed(pw.pos.y));
+        }
+        flush(c[2]); flush(c[0]); flush(c[1]);
+
+        // Tiles as (char, run length), row-major over this chunk's tile block
+        if (L.tileSize > 0.f && !L.tileRows.empty()) {
+            int tx0, tx1, ty0, ty1;
+            tileSpan(chunk % grid.cols, grid.cols, tileColsOf(L), L.tileSize, tx0, tx1);
+            tileSpan(chunk / grid.cols, grid.rows, static_cast<int>(L.tileRows.size()), L.tileSize, ty0, ty1);
+            int runChar = -1;
+            std::int32_t runLen = 0;
+            for (int y = ty0; y < ty1; ++y) {
+                const std::string& row = L.tileRows[y];
+                for (int x = tx0; x < tx1; ++x) {
+                    int ch = x < static_cast<int>(row.size()) ? static_cast<unsigned char>(row[x]) : '.';
+                    if (ch == runChar) { runLen++; continue; }
+                    if (runLen > 0) { c[0].push_back(runChar); c[1].push_back(runLen); }
+                    runChar = ch;
+                    runLen = 1;
+                }
+            }
+            if (runLen > 0) { c[0].push_back(runChar); c[1].push_back(runLen); }
+            dir.counts[TileRuns] = static_cast<std::uint32_t>(c[0].size());
+        }
+        flush(c[0]); flush(c[1]);
+        return out;
+    }
+
+    inline std::vector<std::uint8_t> encodeLevelFile(const LevelDef& L) {
+        ChunkGrid grid(L.worldW, L.worldH);
+        int chunkCount = grid.cols * grid.rows;
+        std::vector<ChunkDir> dirs(chunkCount);
+        std::vector<std::vector<std::uint8_t>> payloads(chunkCount);
+        for (int i = 0; i < chunkCount; ++i) payloads[i] = encodeChunk(L, grid, i, dirs[i]);
+
+        std::vector<std::uint8_t> out;
+        put(out, MAGIC);
+        put(out, VERSION);
+        const std::size_t sumAt = out.size();
+        put(out, std::uint64_t{ 0 });
+        put(out, static_cast<std::uint16_t>(L.name.size()));
+        out.insert(out.end(), L.name.begin(), L.name.end());
+        for (float f : { L.worldW, L.worldH, L.playerSpawn.x, L.playerSpawn.y, L.timeLimit, L.tileSize }) put(out, f);
+        put(out, static_cast<std::uint32_t>(tileColsOf(L)));
+        put(out, static_cast<std::uint32_t>(L.tileRows.size()));
+        put(out, static_cast<std::uint32_t>(grid.cols));
+        put(out, static_cast<std::uint32_t>(grid.rows));
+
+        std::size_t dirAt = out.size();
+        out.resize(out.size() + sizeof(ChunkDir) * chunkCount);
+        for (int i = 0; i < chunkCount; ++i) {
+            dirs[i].offset = static_cast<std::uint32_t>(out.size());
+            dirs[i].bytes = static_cast<std::uint32_t>(payloads[i].size());
+            out.insert(out.end(), payloads[i].begin(), payloads[i].end());
+        }
+        std::memcpy(out.data() + dirAt, dirs.data(), sizeof(ChunkDir) * chunkCount);
+        const std::uint64_t sum = checksum(out.data() + sumAt + sizeof(sum), out.data() + out.size());
+        std::memcpy(out.data() + sumAt, &sum, sizeof(sum));
+        return out;
+    }
+
+    inline bool saveLevelFile(const std::string& path, const LevelDef& L) {
+        std::vector<std::uint8_t> out = encodeLevelFile(L);
+        std::ofstream f(path, std::ios::binary);
+        if (!f || !f.write(reinterpret_cast<const char*>(out.data()), static_cast<std::streamsize>(out.size()))) {
+            std::cout << "Failed to write level file: " << path << "\n";
+            return false;
+        }
+        return true;
+    }
+
+    // ---------------- Decode ----------------
+
+    struct LoadStats {
+        std::size_t fileBytes = 0;
+        int chunks = 0;
+        int threads = 0;
+        double decodeMs = 0.0;
+    };
+
+    // Where each chunk's objects go in the preallocated output arrays.
+    struct ChunkSlot {
+        std::size_t at[COUNT_KINDS];
+    };
+
+    inline bool decodeChunk(const std::uint8_t* p, const std::uint8_t* end, const ChunkDir& dir, const ChunkSlot& slot,
+                            const ChunkGrid& grid, int chunk, int tileCols, LevelDef& L, std::vector<std::int32_t>& scratch) {
+        std::size_t most = 0;
+        for (std::uint32_t n : dir.counts) most = std::max<std::size_t>(most, n);
+        most = std::max<std::size_t>(most, dir.counts[PolyPts]);
+        if (scratch.size() < most * 4) scratch.resize(most * 4);
+        std::int32_t* a = scratch.data();
+        std::int32_t* b = a + most;
+        std::int32_t* c = b + most;
+        std::int32_t* d = c + most;
+
+        std::size_t n = dir.counts[Rects];
+        if (!decodeColumn(p, end, a, n) || !decodeColumn(p, end, b, n) || !decodeColumn(p, end, c, n) || !decodeColumn(p, end, d, n)) return false;
+        for (std::size_t i = 0; i < n; ++i) {
+            L.wallRects[slot.at[Rects] + i] = { fromFixed(a[i]), fromFixed(b[i]), fromFixed(c[i]), fromFixed(d[i]) };
+        }
+
+        n = dir.counts[Polys];
+        std::size_t pts = dir.counts[PolyPts];
+        if (!decodeColumn(p, end, c, n) || !decodeColumn(p, end, a, pts) || !decodeColumn(p, end, b, pts)) return false;
+        for (std::size_t i = 0, k = 0; i < n; ++i) {
+            if (c[i] < 0 || k + static_cast<std::size_t>(c[i]) > pts) return false;
+            ConvexPoly& poly = L.polygons[slot.at[Polys] + i];
+            poly.pts.resize(static_cast<std::size_t>(c[i]));
+            for (auto& v : poly.pts) { v = { fromFixed(a[k]), fromFixed(b[k]) }; ++k; }
+        }
+
+        n = dir.counts[Circles];
+        if (!decodeColumn(p, end, a, n) || !decodeColumn(p, end, b, n) || !decodeColumn(p, end, c, n)) return false;
+        for (std::size_t i = 0; i < n; ++i) {
+            L.circles[slot.at[Circles] + i] = { { fromFixed(a[i]), fromFixed(b[i]) }, fromFixed(c[i]) };
+        }
+
+        n = dir.counts[Targets];
+        if (!decodeColumn(p, end, a, n) || !decodeColumn(p, end, b, n)) return false;
+        for (std::size_t i = 0; i < n; ++i) L.targetSpawns[slot.at[Targets] + i] = { fromFixed(a[i]), fromFixed(b[i]) };
+
+        n = dir.counts[Powerups];
+        if (!decodeColumn(p, end, c, n) || !decodeColumn(p, end, a, n) || !decodeColumn(p, end, b, n)) return false;
+        for (std::size_t i = 0; i < n; ++i) {
+            if (c[i] < 0 || c[i] > static_cast<std::int32_t>(PowerType::FullLight)) return false;
+            L.powerups[slot.at[Powerups] + i] = { static_cast<PowerType>(c[i]), { fromFixed(a[i]), fromFixed(b[i]) }, true };
+        }
+
+        n = dir.counts[TileRuns];
+        if (!decodeColumn(p, end, a, n) || !decodeColumn(p, end, b, n)) return false;
+        if (n > 0) {
+            int tx0, tx1, ty0, ty1;
+            tileSpan(chunk % grid.cols, grid.cols, tileCols, L.tileSize, tx0, tx1);
+            tileSpan(chunk / grid.cols, grid.rows, static_cast<int>(L.tileRows.size()), L.tileSize, ty0, ty1);
+            int spanW = tx1 - tx0;
+            std::size_t cell = 0, cells = static_cast<std::size_t>(spanW) * (ty1 - ty0);
+            for (std::size_t i = 0; i < n; ++i) {
+                if (b[i] <= 0 || cell + static_cast<std::size_t>(b[i]) > cells) return false;
+                for (std::int32_t k = 0; k < b[i]; ++k, ++cell) {
+                    int x = tx0 + static_cast<int>(cell % spanW);
+                    int y = ty0 + static_cast<int>(cell / spanW);
+                    L.tileRows[y][x] = static_cast<char>(a[i]);
+                }
+            }
+        }
+        return true;
+    }
+
+    // Decodes a whole file image; 'path' only names it in messages.
+    // threads = 0 picks hardware_concurrency.
+    inline bool decodeLevelFile(const std::vector<std::uint8_t>& data, const std::string& path, LevelDef& L,
+                                unsigned threads = 0, LoadStats* stats = nullptr) {
+        auto t0 = std::chrono::steady_clock::now();
+        const std::uint8_t* p = data.data();
+        const std::uint8_t* end = p + data.size();
+        auto bad = [&](const char* why) {
+            std::cout << "Bad level file " << path << ": " << why << "\n";
+            return false;
+            };
+
+        std::uint32_t magic = 0, version = 0;
+        std::uint64_t sum = 0;
+        if (!get(p, end, magic) || magic != MAGIC) return bad("not a level file");
+        if (!get(p, end, version) || version != VERSION) return bad("unsupported version");
+        if (!get(p, end, sum) || sum != checksum(p, end)) return bad("checksum mismatch (truncated or damaged)");
+
+        std::uint16_t nameLen = 0;
+        if (!get(p, end, nameLen) || static_cast<std::size_t>(end - p) < nameLen) return bad("truncated header");
+        L = LevelDef{};
+        L.name.assign(reinterpret_cast<const char*>(p), nameLen);
+        p += nameLen;
+
+        float spawnX = 0.f, spawnY = 0.f;
+        std::uint32_t tileCols = 0, tileRows = 0, chunkCols = 0, chunkRows = 0;
+        if (!get(p, end, L.worldW) || !get(p, end, L.worldH) || !get(p, end, spawnX) || !get(p, end, spawnY) ||
+            !get(p, end, L.timeLimit) || !get(p, end, L.tileSize) ||
+            !get(p, end, tileCols) || !get(p, end, tileRows) || !get(p, end, chunkCols) || !get(p, end, chunkRows)) {
+            return bad("truncated header");
+        }
+        L.playerSpawn = { spawnX, spawnY };
+        if (!std::isfinite(spawnX) || !std::isfinite(spawnY) || !std::isfinite(L.timeLimit) || !std::isfinite(L.tileSize)) {
+            return bad("non-finite header value");
+        }
+        if (!(L.worldW > 0.f && L.worldW < MAX_WORLD && L.worldH > 0.f && L.worldH < MAX_WORLD)) return bad("bad world size");
+        if (static_cast<std::uint64_t>(tileCols) * tileRows > MAX_TILES) return bad("tile grid too large");
+
+        ChunkGrid grid(L.worldW, L.worldH);
+        if (static_cast<int>(chunkCols) != grid.cols || static_cast<int>(chunkRows) != grid.rows) return bad("chunk grid mismatch");
+        std::size_t chunkCount = static_cast<std::size_t>(chunkCols) * chunkRows;
+        if (static_cast<std::size_t>(end - p) / sizeof(ChunkDir) < chunkCount) return bad("truncated directory");
+        std::vector<ChunkDir> dirs(chunkCount);
+        std::memcpy(dirs.data(), p, sizeof(ChunkDir) * chunkCount);
+
+        // Size every output array up front; chunk i owns a fixed slice of each
+        std::vector<ChunkSlot> slots(chunkCount);
+        std::size_t total[COUNT_KINDS] = {};
+        for (std::size_t i = 0; i < chunkCount; ++i) {
+            if (dirs[i].offset > data.size() || dirs[i].bytes > data.size() - dirs[i].offset) return bad("chunk out of range");
+            // Every value costs at least one width byte per BLOCK, so counts
+            // larger than that cannot be real (and must not size allocations).
+            std::uint64_t values = 0;
+            for (std::uint32_t n : dirs[i].counts) values += n;
+            if (values > static_cast<std::uint64_t>(dirs[i].bytes) * BLOCK) return bad("chunk counts out of range");
+            for (int k = 0; k < COUNT_KINDS; ++k) {
+                slots[i].at[k] = total[k];
+                total[k] += dirs[i].counts[k];
+            }
+        }
+        L.wallRects.resize(total[Rects]);
+        L.polygons.resize(total[Polys]);
+        L.circles.resize(total[Circles]);
+        L.targetSpawns.resize(total[Targets]);
+        L.powerups.resize(total[Powerups]);
+        if (L.tileSize > 0.f) L.tileRows.assign(tileRows, std::string(tileCols, '.'));
+
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        threads = static_cast<unsigned>(std::min<std::size_t>(threads, chunkCount));
+
+        std::atomic<std::size_t> next{ 0 };
+        std::atomic<bool> ok{ true };
+        auto work = [&]() {
+            std::vector<std::int32_t> scratch;
+            for (std::size_t i = next++; i < chunkCount && ok.load(std::memory_order_relaxed); i = next++) {
+                const std::uint8_t* cp = data.data() + dirs[i].offset;
+                if (!decodeChunk(cp, cp + dirs[i].bytes, dirs[i], slots[i], grid, static_cast<int>(i),
+                                 static_cast<int>(tileCols), L, scratch)) {
+                    ok = false;
+                }
+            }
+            };
+        std::vector<std::thread> pool;
+        for (unsigned t = 1; t < threads; ++t) pool.emplace_back(work);
+        work();
+        for (auto& t : pool) t.join();
+
+        if (!ok) return bad("corrupt chunk");
+        if (stats) {
+            stats->fileBytes = data.size();
+            stats->chunks = static_cast<int>(chunkCount);
+            stats->threads = static_cast<int>(threads);
+            stats->decodeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        }
+        return true;
+    }
+
+    inline bool loadLevelFile(const std::string& path, LevelDef& L, unsigned threads = 0, LoadStats* stats = nullptr) {
+        std::ifstream f(path, std::ios::binary | std::ios::ate);
+        if (!f) {
+            std::cout << "Failed to open level file: " << path << "\n";
+            return false;
+        }
+        const std::streamoff size = f.tellg();
+        if (size < 0 || static_cast<std::uint64_t>(size) > MAX_FILE_BYTES) {
+            std::cout << "Bad level file " << path << ": not a readable file of at most 4 GiB\n";
+            return false;
+        }
+        std::vector<std::uint8_t> data(static_cast<std::size_t>(size));
+        f.seekg(0);
+        if (!f.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()))) {
+            std::cout << "Failed to read level file: " << path << "\n";
+            return false;
+        }
+        return decodeLevelFile(data, path, L, threads, stats);
+    }
+}
@@ -0,0 +1,515 @@
+// LevelText.h
+// Text level format (.mglt) for hand-authored levels.
+//
+// The syntax is JSON with a few conveniences for people typing it: keys may
+// be bare identifiers, trailing commas are fine and // starts a comment.
+//
+//   {
+//     name: "Two Rooms",
+//     world: [2400, 1600],           // width, height
+//     spawn: [200, 800],
+//     timeLimit: 30,
+//     walls: [[0, 0, 2400, 40], ...],   // x, y, w, h
+//     targets: [[1800, 400], ...],
+//     powerups: [{ type: "Speed", pos: [600, 300] }, ...],
+//     polygons: [[[900, 700], [1000, 650], [1050, 800]], ...],
+//     circles: [[1200, 900, 60], ...],  // x, y, radius
+//     tileSize: 64,
+//     tiles: ["....##..", "....##..", ...]
+//   }
+//
+// name, world and spawn are required; everything else defaults to empty
+// (timeLimit to 30). Keys may come in any order. Numbers must be finite:
+// from_chars reads nan and inf, and the parser refuses them.
+//
+// The file is memory-mapped and parsed in place: tokens are string_views
+// into the mapping and numbers are read with from_chars, so the only
+// allocations are the LevelDef's own arrays and strings. Positions are byte
+// offsets until something goes wrong; only then is the line and column
+// worked out for the message.
+
+#pragma once
+
+#include "Level.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <initializer_list>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace leveltext {
+
+    constexpr float MAX_WORLD = 1.0e6f;
+    constexpr std::size_t MAX_TILE_CELLS = 1u << 26;
+
+    // ---------------- Mapped file ----------------
+
+    // Read-only view of a whole file; empty files map to an empty view.
+    class MappedFile {
+    public:
+        MappedFile() = default;
+        ~MappedFile() { close(); }
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        bool open(const std::string& path) {
+            close();
+#ifdef _WIN32
+            file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (file == INVALID_HANDLE_VALUE) return false;
+            LARGE_INTEGER size;
+            if (!GetFileSizeEx(file, &size)) { close(); return false; }
+            bytes = static_cast<std::size_t>(size.QuadPart);
+            if (bytes == 0) return true;
+            mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (!mapping) { close(); return false; }
+            base = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            if (!base) { close(); return false; }
+#else
+            fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) return false;
+            struct stat st;
+            if (fstat(fd, &st) != 0) { close(); return false; }
+            bytes = static_cast<std::size_t>(st.st_size);
+            if (bytes == 0) return true;
+            base = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (base == MAP_FAILED) { base = nullptr; close(); return false; }
+#endif
+            return true;
+        }
+
+        void close() {
+#ifdef _WIN32
+            if (base) UnmapViewOfFile(base);
+            if (mapping) CloseHandle(mapping);
+            if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+            mapping = nullptr;
+            file = INVALID_HANDLE_VALUE;
+#else
+            if (base) munmap(base, bytes);
+            if (fd >= 0) ::close(fd);
+            fd = -1;
+#endif
+            base = nullptr;
+            bytes = 0;
+        }
+
+        std::string_view view() const { return base ? std::string_view(static_cast<const char*>(base), bytes) : std::string_view(); }
+        std::size_t size() const { return bytes; }
+
+    private:
+        void* base = nullptr;
+        std::size_t bytes = 0;
+#ifdef _WIN32
+        HANDLE file = INVALID_HANDLE_VALUE;
+        HANDLE mapping = nullptr;
+#else
+        int fd = -1;
+#endif
+    };
+
+    // ---------------- Parser ----------------
+
+    struct ParseError {
+        int line = 0;      // 1-based
+        int column = 0;    // 1-based, in bytes
+        std::string message;
+    };
+
+    class Parser {
+    public:
+        explicit Parser(std::string_view text) : src(text) {}
+
+        bool parse(LevelDef& L) {
+            L = LevelDef{};
+            bool haveName = false, haveWorld = false, haveSpawn = false;
+            skipSpace();
+            if (!expect('{')) return false;
+            skipSpace();
+            while (!peek('}')) {
+                std::size_t keyAt = pos;
+                std::string_view key;
+                if (!readKey(key)) return false;
+                skipSpace();
+                if (!expect(':')) return false;
+                skipSpace();
+
+                bool ok;
+                if (key == "name") { ok = readString(L.name); haveName = true; }
+                else if (key == "world") { sf::Vector2f v; ok = readVec2(v); L.worldW = v.x; L.worldH = v.y; haveWorld = true; }
+                else if (key == "spawn") { ok = readVec2(L.playerSpawn); haveSpawn = true; }
+                else if (key == "timeLimit") ok = readNumber(L.timeLimit);
+                else if (key == "tileSize") ok = readNumber(L.tileSize);
+                else if (key == "walls") ok = readList([&] { return readRect(L.wallRects.emplace_back()); });
+                else if (key == "targets") ok = readList([&] { return readVec2(L.targetSpawns.emplace_back()); });
+                else if (key == "powerups") ok = readList([&] { return readPowerup(L.powerups.emplace_back()); });
+                else if (key == "circles") ok = readList([&] { return readCircle(L.circles.emplace_back()); });
+                else if (key == "tiles") ok = readList([&] { return readString(L.tileRows.emplace_back()); });
+                else if (key == "polygons") {
+                    ok = readList([&] {
+                        std::size_t polyAt = pos;
+                        ConvexPoly& p = L.polygons.emplace_back();
+                        if (!readList([&] { return readVec2(p.pts.emplace_back()); })) return false;
+                        if (p.pts.size() < 3) { pos = polyAt; return fail("a polygon needs at least 3 points"); }
+                        return true;
+                        });
+                }
+                else { pos = keyAt; return fail("unknown key '" + std::string(key) + "'"); }
+                if (!ok) return false;
+
+                skipSpace();
+                if (peek(',')) { pos++; skipSpace(); }
+                else if (!peek('}')) return fail("expected ',' or '}'");
+            }
+            pos++;
+            skipSpace();
+            if (pos < src.size()) return fail("unexpected text after the level");
+
+            pos = 0;
+            if (!haveName) return fail("missing 'name'");
+            if (!haveWorld) return fail("missing 'world'");
+            if (!haveSpawn) return fail("missing 'spawn'");
+            if (!(L.worldW > 0.f && L.worldW < MAX_WORLD && L.worldH > 0.f && L.worldH < MAX_WORLD)) return fail("bad world size");
+            if (!(L.timeLimit > 0.f)) return fail("timeLimit must be positive");
+            if (L.tileSize < 0.f) return fail("tileSize must not be negative");
+            std::size_t cells = 0;
+            for (const auto& row : L.tileRows) cells += row.size();
+            if (cells > MAX_TILE_CELLS) return fail("tile grid too large");
+            return true;
+        }
+
+        // Only meaningful after parse() failed.
+        ParseError error() const {
+            ParseError e;
+            e.line = 1;
+            e.column = 1;
+            for (std::size_t i = 0; i < errAt && i < src.size(); ++i) {
+                if (src[i] == '\n') { e.line++; e.column = 1; }
+                else e.column++;
+            }
+            e.message = errWhy;
+            return e;
+        }
+
+    private:
+        bool fail(std::string why) {
+            if (errWhy.empty()) { errWhy = std::move(why); errAt = pos; }
+            return false;
+        }
+
+        bool peek(char c) const { return pos < src.size() && src[pos] == c; }
+
+        bool expect(char c) {
+            if (peek(c)) { pos++; return true; }
+            return fail(std::string("expected '") + c + "'");
+        }
+
+        void skipSpace() {
+            while (pos < src.size()) {
+                char c = src[pos];
+                if (c == ' ' || c == '\t' || c == '\n' || c == '\r') pos++;
+                else if (c == '/' && pos + 1 < src.size() && src[pos + 1] == '/') {
+                    while (pos < src.size() && src[pos] != '\n') pos++;
+                }
+                else break;
+            }
+        }
+
+        static bool isIdent(char c) {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+        }
+
+        // The raw text between the quotes; escapes are left in.
+        bool readQuoted(std::string_view& raw) {
+            if (!peek('"')) return fail("expected a string");
+            std::size_t start = ++pos;
+            while (pos < src.size() && src[pos] != '"') {
+                if (src[pos] == '\n') return fail("unterminated string");
+                if (src[pos] == '\\') pos++;
+                pos++;
+            }
+            if (pos >= src.size()) return fail("unterminated string");
+            raw = src.substr(start, pos - start);
+            pos++;
+            return true;
+        }
+
+        bool readKey(std::string_view& key) {
+            if (peek('"')) return readQuoted(key);
+            std::size_t start = pos;
+            while (pos < src.size() && isIdent(src[pos])) pos++;
+            if (pos == start) return fail("expected a key");
+            key = src.substr(start, pos - start);
+            return true;
+        }
+
+        bool readString(std::string& out) {
+            std::size_t at = pos;
+            std::string_view raw;
+            if (!readQuoted(raw)) return false;
+            out.clear();
+            out.reserve(raw.size());
+            for (std::size_t i = 0; i < raw.size(); ++i) {
+                if (raw[i] != '\\') { out.push_back(raw[i]); continue; }
+                char e = raw[++i];
+                if (e == '"' || e == '\\' || e == '/') out.push_back(e);
+                else if (e == 'n') out.push_back('\n');
+                else if (e == 't') out.push_back('\t');
+                else { pos = at + 1 + i; return fail("unsupported escape"); }
+            }
+            return true;
+        }
+
+        bool readNumber(float& v) {
+            const char* first = src.data() + pos;
+            const char* last = src.data() + src.size();
+            if (first != last && *first == '+') first++;   // from_chars takes '-' but not '+'
+            auto [ptr, ec] = std::from_chars(first, last, v);
+            if (ec == std::errc::result_out_of_range) return fail("number out of range");
+            if (ec != std::errc()) return fail("expected a number");
+            if (!std::isfinite(v)) return fail("number must be finite");
+            pos = static_cast<std::size_t>(ptr - src.data());
+            return true;
+        }
+
+        // '[' item (',' item)* ','? ']', with item() reading one element.
+        template <typename F>
+        bool readList(F&& item) {
+            if (!expect('[')) return false;
+            skipSpace();
+            while (!peek(']')) {
+                if (!item()) return false;
+                skipSpace();
+                if (peek(',')) { pos++; skipSpace(); }
+                else if (!peek(']')) return fail("expected ',' or ']'");
+            }
+            pos++;
+            return true;
+        }
+
+        // A fixed-length array of numbers.
+        template <std::size_t N>
+        bool readNumbers(float (&out)[N]) {
+            std::size_t at = pos;
+            std::size_t n = 0;
+            bool ok = readList([&] {
+                if (n == N) return fail("expected " + std::to_string(N) + " numbers");
+                return readNumber(out[n++]);
+                });
+            if (!ok) return false;
+            if (n != N) { pos = at; return fail("expected " + std::to_string(N) + " numbers"); }
+            return true;
+        }
+
+        bool readVec2(sf::Vector2f& v) {
+            float a[2];
+            if (!readNumbers(a)) return false;
+            v = { a[0], a[1] };
+            return true;
+        }
+
+        bool readRect(RectF& r) {
+            float a[4];
+            if (!readNumbers(a)) return false;
+            r = { a[0], a[1], a[2], a[3] };
+            return true;
+        }
+
+        bool readCircle(CircleObstacle& c) {
+            float a[3];
+            if (!readNumbers(a)) return false;
+            c = { { a[0], a[1] }, a[2] };
+            return true;
+        }
+
+        bool readPowerup(PowerUp& p) {
+            bool haveType = false, havePos = false;
+            std::size_t at = pos;
+            if (!expect('{')) return false;
+            skipSpace();
+            while (!peek('}')) {
+                std::size_t keyAt = pos;
+                std::string_view key;
+                if (!readKey(key)) return false;
+                skipSpace();
+                if (!expect(':')) return false;
+                skipSpace();
+                if (key == "type") {
+                    std::size_t typeAt = pos;
+                    std::string_view name;
+                    if (!readQuoted(name)) return false;
+                    if (name == "AddTime") p.type = PowerType::AddTime;
+                    else if (name == "Speed") p.type = PowerType::Speed;
+                    else if (name == "Arrow") p.type = PowerType::Arrow;
+                    else if (name == "FullLight") p.type = PowerType::FullLight;
+                    else { pos = typeAt; return fail("unknown powerup type '" + std::string(name) + "'"); }
+                    haveType = true;
+                }
+                else if (key == "pos") {
+                    if (!readVec2(p.pos)) return false;
+                    havePos = true;
+                }
+                else { pos = keyAt; return fail("unknown powerup key '" + std::string(key) + "'"); }
+                skipSpace();
+                if (peek(',')) { pos++; skipSpace(); }
+                else if (!peek('}')) return fail("expected ',' or '}'");
+            }
+            pos++;
+            if (!haveType || !havePos) { pos = at; return fail("a powerup needs 'type' and 'pos'"); }
+            return true;
+        }
+
+        std::string_view src;
+        std::size_t pos = 0;
+        std::string errWhy;
+        std::size_t errAt = 0;
+    };
+
+    inline bool parseLevelText(std::string_view text, LevelDef& L, ParseError* err = nullptr) {
+        Parser p(text);
+        if (p.parse(L)) return true;
+        if (err) *err = p.error();
+        return false;
+    }
+
+    // ---------------- Files ----------------
+
+    struct LoadStats {
+        std::size_t fileBytes = 0;
+        double parseMs = 0.0;
+    };
+
+    // Errors are printed as path:line:column: message.
+    inline bool loadLevelText(const std::string& path, LevelDef& L, LoadStats* stats = nullptr) {
+        MappedFile file;
+        if (!file.open(path)) {
+            std::cout << "Failed to open level file: " << path << "\n";
+            return false;
+        }
+        auto t0 = std::chrono::steady_clock::now();
+        ParseError err;
+        bool ok = parseLevelText(file.view(), L, &err);
+        if (stats) {
+            stats->fileBytes = file.size();
+            stats->parseMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        }
+        if (!ok) std::cout << path << ":" << err.line << ":" << err.column << ": " << err.message << "\n";
+        return ok;
+    }
+
+    // Shortest text that reads back to the same float, so a level survives
+    // a save / load round trip bit for bit.
+    inline void appendNumber(std::string& out, float v) {
+        char buf[32];
+        auto [ptr, ec] = std::to_chars(buf, buf + sizeof(buf), v);
+        out.append(buf, ec == std::errc() ? ptr : buf);
+    }
+
+    inline void appendString(std::string& out, const std::string& s) {
+        out.push_back('"');
+        for (char c : s) {
+            if (c == '"' || c == '\\') out.push_back('\\');
+            if (c == '\n') { out += "\\n"; continue; }
+            if (c == '\t') { out += "\\t"; continue; }
+            out.push_back(c);
+        }
+        out.push_back('"');
+    }
+
+    inline std::string formatLevelText(const LevelDef& L) {
+        std::string out;
+        auto nums = [&](std::initializer_list<float> vs) {
+            out.push_back('[');
+            bool first = true;
+            for (float v : vs) {
+                if (!first) out += ", ";
+                appendNumber(out, v);
+                first = false;
+            }
+            out.push_back(']');
+            };
+        auto list = [&](const char* key, std::size_t n, auto&& item) {
+            if (n == 0) return;
+            out += "  ";
+            out += key;
+            out += ": [\n";
+            for (std::size_t i = 0; i < n; ++i) {
+                out += "    ";
+                item(i);
+                out += ",\n";
+            }
+            out += "  ],\n";
+            };
+
+        out += "{\n  name: ";
+        appendString(out, L.name);
+        out += ",\n  world: ";
+        nums({ L.worldW, L.worldH });
+        out += ",\n  spawn: ";
+        nums({ L.playerSpawn.x, L.playerSpawn.y });
+        out += ",\n  timeLimit: ";
+        appendNumber(out, L.timeLimit);
+        out += ",\n";
+        list("walls", L.wallRects.size(), [&](std::size_t i) { const RectF& r = L.wallRects[i]; nums({ r.x, r.y, r.w, r.h }); });
+        list("targets", L.targetSpawns.size(), [&](std::size_t i) { nums({ L.targetSpawns[i].x, L.targetSpawns[i].y }); });
+        list("powerups", L.powerups.size(), [&](std::size_t i) {
+            static const char* const names[] = { "AddTime", "Speed", "Arrow", "FullLight" };
+            const PowerUp& p = L.powerups[i];
+            out += "{ type: \"";
+            out += names[static_cast<int>(p.type)];
+            out += "\", pos: ";
+            nums({ p.pos.x, p.pos.y });
+            out += " }";
+            });
+        list("polygons", L.polygons.size(), [&](std::size_t i) {
+            out.push_back('[');
+            for (std::size_t k = 0; k < L.polygons[i].pts.size(); ++k) {
+                if (k) out += ", ";
+                nums({ L.polygons[i].pts[k].x, L.polygons[i].pts[k].y });
+            }
+            out.push_back(']');
+            });
+        list("circles", L.circles.size(), [&](std::size_t i) { const CircleObstacle& c = L.circles[i]; nums({ c.c.x, c.c.y, c.r }); });
+        if (L.tileSize > 0.f || !L.tileRows.empty()) {
+            out += "  tileSize: ";
+            appendNumber(out, L.tileSize);
+            out += ",\n";
+            list("tiles", L.tileRows.size(), [&](std::size_t i) { appendString(out, L.tileRows[i]); });
+        }
+        out += "}\n";
+        return out;
+    }
+
+    inline bool saveLevelText(const std::string& path, const LevelDef& L) {
+        std::string text = formatLevelText(L);
+        std::ofstream f(path, std::ios::binary);
+        if (!f || !f.write(text.data(), static_cast<std::streamsize>(text.size()))) {
+            std::cout << "Failed to write level file: " << path << "\n";
+            return false;
+        }
+        return true;
+    }
+
+} // namespace leveltext
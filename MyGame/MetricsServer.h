@@ -0,0 +1,273 @@
+// MetricsServer.h
+// Optional live metrics endpoint on a Unix domain socket.
+//
+// The game loop publishes a MetricsSnapshot once in a while through a seqlock;
+// the server thread copies it out without ever taking a lock the game thread
+// could wait on. Any client that connects gets one snapshot and is closed:
+//
+//     echo json | nc -U /tmp/mygame.sock       (or "text", the default)
+//
+// Windows 10+ has AF_UNIX in winsock, so the same code runs there.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <winsock2.h>
+#include <afunix.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+struct MetricsSnapshot {
+    std::uint64_t frame = 0;
+    float fps = 0.f;
+    float frameMsP50 = 0.f;
+    float frameMsP99 = 0.f;
+    float frameMsMax = 0.f;
+    float visibilityUs = 0.f;       // last computeVisibilityPolygon call
+    std::uint32_t visibilityVerts = 0;
+    bool visibilityPerf = false;    // counters below are only meaningful when set
+    std::uint64_t visibilityCycles = 0;
+    std::uint64_t visibilityInstructions = 0;
+    std::uint64_t visibilityCacheMisses = 0;
+    std::uint64_t visibilityBranchMisses = 0;
+    std::int32_t level = 0;         // 0 = menu
+    std::int32_t mode = 0;          // GameMode as int
+    std::uint32_t targetsLeft = 0;
+    float timeLeft = 0.f;
+    std::uint64_t textureBytes = 0;
+    std::uint64_t textureBudget = 0;
+    std::uint64_t floorBytes = 0;
+};
+
+// Single writer, many readers. The payload lives in relaxed atomic words so
+// a torn read is merely discarded (the sequence number changed), never UB.
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable_v<T>, "SeqLock payload must be trivially copyable");
+    static constexpr std::size_t WORDS = (sizeof(T) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+
+public:
+    void store(const T& value) {
+        std::array<std::uint64_t, WORDS> raw{};
+        std::memcpy(raw.data(), &value, sizeof(T));
+
+        std::uint64_t s = seq.load(std::memory_order_relaxed);
+        seq.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (std::size_t i = 0; i < WORDS; ++i) words[i].store(raw[i], std::memory_order_relaxed);
+        seq.store(s + 2, std::memory_order_release);
+    }
+
+    T load() const {
+        std::array<std::uint64_t, WORDS> raw{};
+        while (true) {
+            std::uint64_t s0 = seq.load(std::memory_order_acquire);
+            if (s0 & 1u) { std::this_thread::yield(); continue; }
+            for (std::size_t i = 0; i < WORDS; ++i) raw[i] = words[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq.load(std::memory_order_relaxed) == s0) break;
+        }
+        T out;
+        std::memcpy(static_cast<void*>(&out), raw.data(), sizeof(T));
+        return out;
+    }
+
+private:
+    std::atomic<std::uint64_t> seq{ 0 };
+    std::array<std::atomic<std::uint64_t>, WORDS> words{};
+};
+
+inline std::string formatMetrics(const MetricsSnapshot& m, bool json) {
+    char buf[768];
+    char perf[256] = "";
+    double ipc = m.visibilityCycles ? static_cast<double>(m.visibilityInstructions) / m.visibilityCycles : 0.0;
+    if (json) {
+        if (m.visibilityPerf) {
+            std::snprintf(perf, sizeof(perf),
+                ",\"visibility_perf\":{\"cycles\":%llu,\"instructions\":%llu,\"ipc\":%.3f,\"cache_misses\":%llu,\"branch_misses\":%llu}",
+                static_cast<unsigned long long>(m.visibilityCycles), static_cast<unsigned long long>(m.visibilityInstructions), ipc,
+                static_cast<unsigned long long>(m.visibilityCacheMisses), static_cast<unsigned long long>(m.visibilityBranchMisses));
+        }
+        std::snprintf(buf, sizeof(buf),
+            "{\"frame\":%llu,\"fps\":%.1f,\"frame_ms\":{\"p50\":%.3f,\"p99\":%.3f,\"max\":%.3f},"
+            "\"visibility_us\":%.1f,\"visibility_verts\":%u%s,\"level\":%d,\"mode\":%d,"
+            "\"targets_left\":%u,\"time_left\":%.1f,"
+            "\"memory\":{\"texture_bytes\":%llu,\"texture_budget\":%llu,\"floor_bytes\":%llu}}\n",
+            static_cast<unsigned long long>(m.frame), m.fps, m.frameMsP50, m.frameMsP99, m.frameMsMax,
+            m.visibilityUs, m.visibilityVerts, perf, m.level, m.mode, m.targetsLeft, m.timeLeft,
+            static_cast<unsigned long long>(m.textureBytes), static_cast<unsigned long long>(m.textureBudget),
+            static_cast<unsigned long long>(m.floorBytes));
+    }
+    else {
+        if (m.visibilityPerf) {
+            std::snprintf(perf, sizeof(perf),
+                "visibility_perf cycles %llu instructions %llu ipc %.3f cache_misses %llu branch_misses %llu\n",
+                static_cast<unsigned long long>(m.visibilityCycles), static_cast<unsigned long long>(m.visibilityInstructions), ipc,
+                static_cast<unsigned long long>(m.visibilityCacheMisses), static_cast<unsigned long long>(m.visibilityBranchMisses));
+        }
+        std::snprintf(buf, sizeof(buf),
+            "frame %llu\nfps %.1f\nframe_ms p50 %.3f p99 %.3f max %.3f\n"
+            "visibility %.1f us, %u verts\n%slevel %d mode %d targets_left %u time_left %.1f\n"
+            "texture_bytes %llu / %llu\nfloor_bytes %llu\n",
+            static_cast<unsigned long long>(m.frame), m.fps, m.frameMsP50, m.frameMsP99, m.frameMsMax,
+            m.visibilityUs, m.visibilityVerts, perf, m.level, m.mode, m.targetsLeft, m.timeLeft,
+            static_cast<unsigned long long>(m.textureBytes), static_cast<unsigned long long>(m.textureBudget),
+            static_cast<unsigned long long>(m.floorBytes));
+    }
+    return buf;
+}
+
+class MetricsServer {
+public:
+    MetricsServer() = default;
+    ~MetricsServer() { stop(); }
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    // Bind and start serving. Returns false (and the game just runs without
+    // metrics) if the socket cannot be created.
+    bool start(const std::string& path) {
+#ifdef _WIN32
+        WSADATA wsa;
+        if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) {
+            std::cout << "Metrics: WSAStartup failed.\n";
+            return false;
+        }
+        wsaStarted = true;
+#endif
+        sockaddr_un addr{};
+        if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+            std::cout << "Metrics: bad socket path '" << path << "'.\n";
+            return false;
+        }
+        addr.sun_family = AF_UNIX;
+        std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+
+        listenSock = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (!isValid(listenSock)) {
+            std::cout << "Metrics: socket() failed.\n";
+            return false;
+        }
+        removeFile(path);   // a stale socket from a crashed run would make bind fail
+        if (bind(listenSock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(listenSock, 4) != 0) {
+            std::cout << "Metrics: cannot listen on " << path << "\n";
+            closeSock(listenSock);
+            listenSock = INVALID;
+            return false;
+        }
+        setNonBlocking(listenSock);
+
+        socketPath = path;
+        running.store(true, std::memory_order_relaxed);
+        thread = std::thread([this] { serve(); });
+        std::cout << "Metrics: serving on " << path << "\n";
+        return true;
+    }
+
+    void stop() {
+        if (thread.joinable()) {
+            running.store(false, std::memory_order_relaxed);
+            thread.join();
+        }
+        if (isValid(listenSock)) {
+            closeSock(listenSock);
+            listenSock = INVALID;
+            removeFile(socketPath);
+        }
+#ifdef _WIN32
+        if (wsaStarted) { WSACleanup(); wsaStarted = false; }
+#endif
+    }
+
+    bool isRunning() const { return running.load(std::memory_order_relaxed); }
+
+    // Game thread; wait-free.
+    void publish(const MetricsSnapshot& m) { latest.store(m); }
+
+private:
+#ifdef _WIN32
+    using Socket = SOCKET;
+    static constexpr Socket INVALID = INVALID_SOCKET;
+    static bool isValid(Socket s) { return s != INVALID_SOCKET; }
+    static void closeSock(Socket s) { closesocket(s); }
+    static void setNonBlocking(Socket s) { u_long on = 1; ioctlsocket(s, FIONBIO, &on); }
+    static int pollOne(Socket s, int timeoutMs) { WSAPOLLFD p{ s, POLLRDNORM, 0 }; return WSAPoll(&p, 1, timeoutMs); }
+    static void removeFile(const std::string& p) { DeleteFileA(p.c_str()); }
+    static constexpr int SEND_FLAGS = 0;
+#else
+    using Socket = int;
+    static constexpr Socket INVALID = -1;
+    static bool isValid(Socket s) { return s >= 0; }
+    static void closeSock(Socket s) { close(s); }
+    static void setNonBlocking(Socket s) { fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK); }
+    static int pollOne(Socket s, int timeoutMs) { pollfd p{ s, POLLIN, 0 }; return poll(&p, 1, timeoutMs); }
+    static void removeFile(const std::string& p) { unlink(p.c_str()); }
+#ifdef MSG_NOSIGNAL
+    static constexpr int SEND_FLAGS = MSG_NOSIGNAL;   // a client hanging up must not kill the game
+#else
+    static constexpr int SEND_FLAGS = 0;
+#endif
+#endif
+
+    void serve() {
+        while (running.load(std::memory_order_relaxed)) {
+            if (pollOne(listenSock, 100) <= 0) continue;
+
+            Socket client = accept(listenSock, nullptr, nullptr);
+            if (!isValid(client)) continue;
+
+            // Optional one-line request ("json" / "text"); give the client a
+            // moment to send it, then answer either way.
+            bool json = false;
+            setNonBlocking(client);
+            if (pollOne(client, 50) > 0) {
+                char req[32] = {};
+                int n = static_cast<int>(recv(client, req, sizeof(req) - 1, 0));
+                if (n > 0) json = std::strncmp(req, "json", 4) == 0;
+            }
+
+            std::string body = formatMetrics(latest.load(), json);
+            const char* p = body.data();
+            std::size_t left = body.size();
+            for (int tries = 0; left > 0 && tries < 20; ++tries) {
+                int n = static_cast<int>(send(client, p, static_cast<int>(left), SEND_FLAGS));
+                if (n > 0) { p += n; left -= static_cast<std::size_t>(n); }
+                else std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            closeSock(client);
+        }
+    }
+
+    SeqLock<MetricsSnapshot> latest;
+    std::atomic<bool> running{ false };
+    Socket listenSock = INVALID;
+    std::string socketPath;
+    std::thread thread;
+#ifdef _WIN32
+    bool wsaStarted = false;
+#endif
+};
@@ -1,6 +1,6 @@
 // MyGame.cpp (SFML 3.x)
 // Levels + Menu + Camera + Wall-occluded 360 vision (range + warm glow)
-// + Powerups: +Time, Speed Boost (temp), Arrow to target (temp), Full Light (temp)
+// + Powerups: +Time, Speed Boost (temp), Arrow to nearest target (temp), Full Light (temp)
 //
 // Files:
 //   assets/fonts/arial.ttf
@@ -8,6 +8,27 @@
 //   assets/sprites/seven1.png, seven2.png
 
 #include <SFML/Graphics.hpp>
+#include "Geometry.h"
+#include "Level.h"
+#include "OccupancyGrid.h"
+#include "WorldGeometry.h"
+#include "FloorLayer.h"
+#include "KdTree.h"
+#include "TextureManager.h"
+#include "MetricsServer.h"
+#include "Env.h"
+#include "Bench.h"
+#include "LevelFile.h"
+#include "LevelText.h"
+#include "Sim.h"
+#include "Rollback.h"
+#include "Server.h"
+#include "PerfCounters.h"
+#include "Visibility.h"
+#include "PathGraph.h"
+#include "LevelArena.h"
+#include "RenderQueue.h"
+#include "Replay.h"
 #include <vector>
 #include <cmath>
 #include <string>
@@ -16,35 +37,13 @@
 #include <optional>
 #include <cstdint>
 #include <limits>
+#include <sstream>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <tuple>
 
 // ---------------- Helpers ----------------
-static sf::Vector2f normalize(sf::Vector2f v) {
-    float len = std::sqrt(v.x * v.x + v.y * v.y);
-    if (len == 0.f) return { 0.f, 0.f };
-    return { v.x / len, v.y / len };
-}
-
-static bool circleIntersectsRect(const sf::Vector2f& c, float r, const sf::FloatRect& rect) {
-    float left = rect.position.x;
-    float top = rect.position.y;
-    float right = rect.position.x + rect.size.x;
-    float bottom = rect.position.y + rect.size.y;
-
-    float closestX = std::max(left, std::min(c.x, right));
-    float closestY = std::max(top, std::min(c.y, bottom));
-
-    float dx = c.x - closestX;
-    float dy = c.y - closestY;
-    return (dx * dx + dy * dy) < (r * r);
-}
-
-static bool circleIntersectsCircle(sf::Vector2f a, float ra, sf::Vector2f b, float rb) {
-    sf::Vector2f d = a - b;
-    float dist2 = d.x * d.x + d.y * d.y;
-    float r = ra + rb;
-    return dist2 < (r * r);
-}
-
 static sf::RectangleShape makeWall(float x, float y, float w, float h) {
     sf::RectangleShape r({ w, h });
     r.setPosition({ x, y });
@@ -52,6 +51,41 @@ static sf::RectangleShape makeWall(float x, float y, float w, float h) {
     return r;
 }
 
+// One batched mesh for all solid tiles: a quad per horizontal run of solid cells
+static sf::VertexArray buildGridMesh(const OccupancyGrid& g, sf::Color color) {
+    sf::VertexArray mesh(sf::PrimitiveType::Triangles);
+    for (int y = 0; y < g.rows; ++y) {
+        int x = 0;
+        while (x < g.cols) {
+            if (!g.get(x, y)) { ++x; continue; }
+            int end = x;
+            while (end < g.cols && g.get(end, y)) ++end;
+
+            float x0 = g.origin.x + x * g.cellSize;
+            float x1 = g.origin.x + end * g.cellSize;
+            float y0 = g.origin.y + y * g.cellSize;
+            float y1 = y0 + g.cellSize;
+            mesh.append(sf::Vertex({ x0, y0 }, color));
+            mesh.append(sf::Vertex({ x1, y0 }, color));
+            mesh.append(sf::Vertex({ x1, y1 }, color));
+            mesh.append(sf::Vertex({ x0, y0 }, color));
+            mesh.append(sf::Vertex({ x1, y1 }, color));
+            mesh.append(sf::Vertex({ x0, y1 }, color));
+            x = end;
+        }
+    }
+    return mesh;
+}
+
+// Stable per-cell floor variant (1..variants) so a level always looks the same
+static std::uint8_t floorVariantAt(int x, int y, int variants) {
+    std::uint32_t h = static_cast<std::uint32_t>(x) * 73856093u ^ static_cast<std::uint32_t>(y) * 19349663u;
+    h ^= h >> 13;
+    h *= 0x5bd1e995u;
+    h ^= h >> 15;
+    return static_cast<std::uint8_t>(1 + h % static_cast<std::uint32_t>(variants));
+}
+
 static void setCentered(sf::Text& t, float cx, float cy) {
     sf::FloatRect b = t.getLocalBounds();
     t.setOrigin({ b.position.x + b.size.x / 2.f,
@@ -59,6 +93,14 @@ static void setCentered(sf::Text& t, float cx, float cy) {
     t.setPosition({ cx, cy });
 }
 
+// sf::Font rasterizes glyphs lazily, per character size, growing its page
+// texture as it goes. Touch every glyph up front so new text never hitches.
+static void prewarmGlyphs(const sf::Font& font, unsigned size, const std::string& charset) {
+    for (char ch : charset) {
+        (void)font.getGlyph(static_cast<unsigned char>(ch), size, false);
+    }
+}
+
 static void fitSpriteToDiameter(sf::Sprite& spr, const sf::Texture& tex, float desiredDiameter) {
     sf::Vector2u s = tex.getSize();
     if (s.x == 0 || s.y == 0) return;
@@ -83,6 +125,16 @@ static sf::Vector2f clampViewCenter(sf::Vector2f desiredCenter, sf::Vector2f vie
     return desiredCenter;
 }
 
+// WASD as simulation InputBits
+static std::uint8_t readMovementInput() {
+    std::uint8_t in = 0;
+    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::W)) in |= INPUT_UP;
+    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::S)) in |= INPUT_DOWN;
+    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::A)) in |= INPUT_LEFT;
+    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::D)) in |= INPUT_RIGHT;
+    return in;
+}
+
 static bool pressedOnce(sf::Keyboard::Key key, bool& wasDown) {
     bool down = sf::Keyboard::isKeyPressed(key);
     bool fire = down && !wasDown;
@@ -103,108 +155,21 @@ static const sf::BlendMode ADD_GLOW(
     sf::BlendMode::Equation::Add
 );
 
-// ---------------- Wall-occluded visibility ----------------
-struct Segment { sf::Vector2f a, b; };
-
-static float cross2(const sf::Vector2f& a, const sf::Vector2f& b) {
-    return a.x * b.y - a.y * b.x;
-}
-
-static bool raySegmentIntersect(
-    const sf::Vector2f& p, const sf::Vector2f& r,
-    const sf::Vector2f& q, const sf::Vector2f& s,
-    float& tHit, sf::Vector2f& hitPoint
-) {
-    float rxs = cross2(r, s);
-    if (std::fabs(rxs) < 1e-8f) return false;
-
-    sf::Vector2f qmp = { q.x - p.x, q.y - p.y };
-    float t = cross2(qmp, s) / rxs;
-    float u = cross2(qmp, r) / rxs;
-
-    if (t >= 0.f && u >= 0.f && u <= 1.f) {
-        tHit = t;
-        hitPoint = { p.x + t * r.x, p.y + t * r.y };
-        return true;
-    }
-    return false;
-}
-
-static std::vector<Segment> buildWallSegments(const std::vector<sf::RectangleShape>& walls) {
-    std::vector<Segment> segs;
-    segs.reserve(walls.size() * 4);
-
-    for (const auto& w : walls) {
-        sf::FloatRect b = w.getGlobalBounds();
-        float x = b.position.x;
-        float y = b.position.y;
-        float ww = b.size.x;
-        float hh = b.size.y;
-
-        sf::Vector2f p1(x, y);
-        sf::Vector2f p2(x + ww, y);
-        sf::Vector2f p3(x + ww, y + hh);
-        sf::Vector2f p4(x, y + hh);
-
-        segs.push_back({ p1, p2 });
-        segs.push_back({ p2, p3 });
-        segs.push_back({ p3, p4 });
-        segs.push_back({ p4, p1 });
-    }
-    return segs;
-}
-
-static std::vector<sf::Vector2f> computeVisibilityPolygon(
-    const sf::Vector2f& origin,
-    const std::vector<Segment>& segs,
-    float maxDist
-) {
-    std::vector<float> angles;
-    angles.reserve(segs.size() * 2 * 3);
-
-    auto addAnglesForPoint = [&](const sf::Vector2f& pt) {
-        float a = std::atan2(pt.y - origin.y, pt.x - origin.x);
-        const float eps = 0.0007f;
-        angles.push_back(a - eps);
-        angles.push_back(a);
-        angles.push_back(a + eps);
-        };
-
-    for (const auto& s : segs) { addAnglesForPoint(s.a); addAnglesForPoint(s.b); }
-
-    struct Hit { float angle; sf::Vector2f p; };
-    std::vector<Hit> hits;
-    hits.reserve(angles.size());
-
-    for (float ang : angles) {
-        sf::Vector2f dir(std::cos(ang), std::sin(ang));
-
-        float bestT = std::numeric_limits<float>::infinity();
-        sf::Vector2f bestP = { origin.x + dir.x * maxDist, origin.y + dir.y * maxDist };
-
-        for (const auto& seg : segs) {
-            sf::Vector2f sdir = { seg.b.x - seg.a.x, seg.b.y - seg.a.y };
-            float tHit;
-            sf::Vector2f hp;
-            if (raySegmentIntersect(origin, dir, seg.a, sdir, tHit, hp)) {
-                if (tHit < bestT && tHit <= maxDist) {
-                    bestT = tHit;
-                    bestP = hp;
-                }
-            }
-        }
-        hits.push_back({ ang, bestP });
-    }
-
-    std::sort(hits.begin(), hits.end(), [](const Hit& a, const Hit& b) {
-        return a.angle < b.angle;
-        });
+// ---------------- Render layers ----------------
+// Submission order of the render queue (see RenderQueue.h). The world layers
+// go out under the camera view, the rest in screen space.
+enum RenderLayer : std::uint8_t {
+    LAYER_POWERUPS,
+    LAYER_POWERUP_LABELS,
+    LAYER_TARGETS,
+    LAYER_WALLS,
+    LAYER_ENTITIES,
+    LAYER_ERASE,    // into darknessRT (render-texture darkness only)
+    LAYER_LIGHT,    // darkness mesh, then the additive glow
+};
 
-    std::vector<sf::Vector2f> poly;
-    poly.reserve(hits.size());
-    for (auto& h : hits) poly.push_back(h.p);
-    return poly;
-}
+// ---------------- Wall-occluded visibility ----------------
+// The polygon itself comes from Visibility.h; this is how it is drawn.
 
 // Soft fan built in SCREEN space (for darkness RT)
 static sf::VertexArray buildSoftFan_Screen(
@@ -244,27 +209,78 @@ static sf::VertexArray buildSoftFan_Screen(
     return fan;
 }
 
-// ---------------- Levels ----------------
-struct RectF { float x, y, w, h; };
+// Darkness in one mesh, drawn straight to the window: the lit polygon carries
+// the falloff as a gradient (alpha = dark * (1 - light)), and everything
+// between the polygon and a ring past the screen corners is fully dark.
+// The polygon is star-shaped around the origin, so extruding each of its
+// edges outward along the vertex directions tiles that band without overlap.
+// Matches what ERASE_BLEND used to leave in darknessRT, minus the RT.
+static sf::VertexArray buildDarknessMesh_Screen(
+    const sf::Vector2f& originScreen,
+    const std::vector<sf::Vector2f>& polyScreen,
+    float maxDist,
+    std::uint8_t darkAlpha,
+    sf::Vector2f screenSize
+) {
+    sf::VertexArray mesh(sf::PrimitiveType::Triangles);
+    const sf::Color dark(0, 0, 0, darkAlpha);
 
-enum class PowerType { AddTime, Speed, Arrow, FullLight };
+    if (polyScreen.size() < 3) {
+        sf::Vector2f c[4] = { { 0.f, 0.f }, { screenSize.x, 0.f }, screenSize, { 0.f, screenSize.y } };
+        for (int i : { 0, 1, 2, 0, 2, 3 }) mesh.append(sf::Vertex(c[i], dark));
+        return mesh;
+    }
 
-struct PowerUp {
-    PowerType type;
-    sf::Vector2f pos;
-    bool active = true;
-};
+    // Ring radius: past the farthest screen corner (and the polygon itself), with
+    // slack for the chord between two neighbouring rays cutting inside the circle.
+    float ring = 0.f;
+    for (sf::Vector2f c : { sf::Vector2f(0.f, 0.f), sf::Vector2f(screenSize.x, 0.f), screenSize, sf::Vector2f(0.f, screenSize.y) }) {
+        ring = std::max(ring, std::hypot(c.x - originScreen.x, c.y - originScreen.y));
+    }
+    for (const auto& p : polyScreen) ring = std::max(ring, std::hypot(p.x - originScreen.x, p.y - originScreen.y));
+    ring = ring * 1.1f + 16.f;
 
-struct LevelDef {
-    std::string name;
-    float worldW;
-    float worldH;
-    sf::Vector2f playerSpawn;
-    sf::Vector2f targetSpawn;
-    std::vector<RectF> wallRects;
-    std::vector<PowerUp> powerups;
-};
+    auto darkAt = [&](const sf::Vector2f& p) {
+        float dist = std::hypot(p.x - originScreen.x, p.y - originScreen.y);
+        float t = std::min(1.f, dist / maxDist);
+        float light = std::max(255.f * (1.f - t), 25.f);
+        float a = darkAlpha * (1.f - light / 255.f);
+        return sf::Color(0, 0, 0, static_cast<std::uint8_t>(std::clamp(a, 0.f, 255.f)));
+        };
+    auto outward = [&](const sf::Vector2f& p) {
+        sf::Vector2f d = p - originScreen;
+        float len = std::hypot(d.x, d.y);
+        if (len < 1e-4f) return originScreen;
+        return originScreen + d * (ring / len);
+        };
 
+    const sf::Color clear(0, 0, 0, 0);
+    const std::size_t n = polyScreen.size();
+    mesh.resize(n * 9);
+    std::size_t v = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        const sf::Vector2f& a = polyScreen[i];
+        const sf::Vector2f& b = polyScreen[(i + 1) % n];
+        sf::Color ca = darkAt(a), cb = darkAt(b);
+        sf::Vector2f qa = outward(a), qb = outward(b);
+
+        // lit wedge
+        mesh[v++] = sf::Vertex(originScreen, clear);
+        mesh[v++] = sf::Vertex(a, ca);
+        mesh[v++] = sf::Vertex(b, cb);
+
+        // dark band behind this edge
+        mesh[v++] = sf::Vertex(a, dark);
+        mesh[v++] = sf::Vertex(qa, dark);
+        mesh[v++] = sf::Vertex(qb, dark);
+        mesh[v++] = sf::Vertex(a, dark);
+        mesh[v++] = sf::Vertex(qb, dark);
+        mesh[v++] = sf::Vertex(b, dark);
+    }
+    return mesh;
+}
+
+// ---------------- Levels ----------------
 static std::vector<LevelDef> makeLevels() {
     std::vector<LevelDef> levels;
 
@@ -274,7 +290,7 @@ static std::vector<LevelDef> makeLevels() {
         L.name = "The Warmup";
         L.worldW = 2400.f; L.worldH = 1800.f;
         L.playerSpawn = { 200.f, 200.f };
-        L.targetSpawn = { 1950.f, 1400.f };
+        L.targetSpawns = { { 1950.f, 1400.f } };
 
         L.wallRects.push_back({ 0, 0, L.worldW, 20 });
         L.wallRects.push_back({ 0, L.worldH - 20, L.worldW, 20 });
@@ -305,7 +321,7 @@ static std::vector<LevelDef> makeLevels() {
         L.name = "Hallway Tricks";
         L.worldW = 2800.f; L.worldH = 2000.f;
         L.playerSpawn = { 140.f, 140.f };
-        L.targetSpawn = { 2550.f, 1750.f };
+        L.targetSpawns = { { 2550.f, 1750.f } };
 
         L.wallRects.push_back({ 0, 0, L.worldW, 20 });
         L.wallRects.push_back({ 0, L.worldH - 20, L.worldW, 20 });
@@ -339,7 +355,7 @@ static std::vector<LevelDef> makeLevels() {
         L.name = "The Split";
         L.worldW = 2600.f; L.worldH = 1900.f;
         L.playerSpawn = { 200.f, 1650.f };
-        L.targetSpawn = { 2350.f, 250.f };
+        L.targetSpawns = { { 2350.f, 250.f } };
 
         L.wallRects.push_back({ 0, 0, L.worldW, 20 });
         L.wallRects.push_back({ 0, L.worldH - 20, L.worldW, 20 });
@@ -370,7 +386,7 @@ static std::vector<LevelDef> makeLevels() {
         L.name = "The Box";
         L.worldW = 2200.f; L.worldH = 1600.f;
         L.playerSpawn = { 140.f, 140.f };
-        L.targetSpawn = { 2050.f, 1450.f };
+        L.targetSpawns = { { 2050.f, 1450.f } };
 
         L.wallRects.push_back({ 0, 0, L.worldW, 20 });
         L.wallRects.push_back({ 0, L.worldH - 20, L.worldW, 20 });
@@ -402,7 +418,7 @@ static std::vector<LevelDef> makeLevels() {
         L.name = "Long Run";
         L.worldW = 3200.f; L.worldH = 1400.f;
         L.playerSpawn = { 160.f, 700.f };
-        L.targetSpawn = { 3050.f, 700.f };
+        L.targetSpawns = { { 3050.f, 700.f } };
 
         L.wallRects.push_back({ 0, 0, L.worldW, 20 });
         L.wallRects.push_back({ 0, L.worldH - 20, L.worldW, 20 });
@@ -435,9 +451,751 @@ static std::vector<LevelDef> makeLevels() {
         levels.push_back(std::move(L));
     }
 
+    // Level 6
+    {
+        LevelDef L;
+        L.name = "The Caves";
+        L.tileSize = 50.f;
+        L.tileRows = {
+            "################################################",
+            "#......##########.........######...............#",
+            "#.......#######............####................#",
+            "#........#####......##......##.......####......#",
+            "##.......####......####..............#####.....#",
+            "###......###......######............#######....#",
+            "####.............########..........#########...#",
+            "#####...........##########........##########...#",
+            "######.........###########.......###########...#",
+            "#######.......###########.......###########....#",
+            "########.......#########.......###########.....#",
+            "#########.......#######.......###########......#",
+            "##########.......#####.......##########.......##",
+            "###########..................#########.......###",
+            "############................#########.......####",
+            "#############..............#########.......#####",
+            "####......####............####.............#####",
+            "###........####..........####.............######",
+            "##..........####........####.............#######",
+            "#....####.....###......####......###.....#######",
+            "#...######.....###.....###......#####.....######",
+            "#...#######.....##.....##......#######.....#####",
+            "#...########.....#.....#......#########.....####",
+            "#....########..................#########.....###",
+            "##....########.................##########.....##",
+            "###....#######........##........##########.....#",
+            "####....#####........####........##########....#",
+            "#####...............######........#########....#",
+            "######.............########........######......#",
+            "#######...........##########...................#",
+            "########.........############..................#",
+            "################################################"
+        };
+        L.worldW = L.tileSize * (float)L.tileRows[0].size();
+        L.worldH = L.tileSize * (float)L.tileRows.size();
+        L.playerSpawn = { 125.f, 125.f };
+        L.targetSpawns = { { 2275.f, 1475.f } };
+
+        L.powerups.push_back({ PowerType::AddTime,   { 1025.f, 675.f },  true });
+        L.powerups.push_back({ PowerType::Speed,     { 1925.f, 125.f },  true });
+        L.powerups.push_back({ PowerType::FullLight, { 175.f,  1025.f }, true });
+        L.powerups.push_back({ PowerType::Arrow,     { 1025.f, 1175.f }, true });
+
+        levels.push_back(std::move(L));
+    }
+
+    // Level 7
+    {
+        LevelDef L;
+        L.name = "Pillars";
+        L.worldW = 2600.f; L.worldH = 1800.f;
+        L.playerSpawn = { 160.f, 160.f };
+        L.targetSpawns = { { 2400.f, 1600.f } };
+
+        L.wallRects.push_back({ 0, 0, L.worldW, 20 });
+        L.wallRects.push_back({ 0, L.worldH - 20, L.worldW, 20 });
+        L.wallRects.push_back({ 0, 0, 20, L.worldH });
+        L.wallRects.push_back({ L.worldW - 20, 0, 20, L.worldH });
+
+        for (int row = 0; row < 4; ++row) {
+            for (int col = 0; col < 6; ++col) {
+                float x = 450.f + col * 330.f + (row % 2) * 165.f;
+                float y = 330.f + row * 360.f;
+                L.circles.push_back({ { x, y }, 45.f + 15.f * ((row + col) % 3) });
+            }
+        }
+
+        L.polygons.push_back(makeRegularPoly({ 300.f, 1550.f }, 110.f, 3, -1.5708f));
+        L.polygons.push_back(makeRegularPoly({ 1300.f, 160.f }, 90.f, 5));
+        L.polygons.push_back(makeRegularPoly({ 2300.f, 900.f }, 120.f, 6, 0.3f));
+        L.polygons.push_back({ { { 1050.f, 1650.f }, { 1500.f, 1600.f }, { 1560.f, 1680.f }, { 1080.f, 1720.f } } });
+
+        L.powerups.push_back({ PowerType::Arrow,     { 285.f,  510.f },  true });
+        L.powerups.push_back({ PowerType::AddTime,   { 1110.f, 690.f },  true });
+        L.powerups.push_back({ PowerType::FullLight, { 2100.f, 1600.f }, true });
+
+        levels.push_back(std::move(L));
+    }
+
+    // Level 8
+    {
+        LevelDef L;
+        L.name = "Seven Heaven";
+        L.worldW = 3600.f; L.worldH = 2400.f;
+        L.playerSpawn = { 1800.f, 1200.f };
+        L.timeLimit = 240.f;
+
+        L.wallRects.push_back({ 0, 0, L.worldW, 20 });
+        L.wallRects.push_back({ 0, L.worldH - 20, L.worldW, 20 });
+        L.wallRects.push_back({ 0, 0, 20, L.worldH });
+        L.wallRects.push_back({ L.worldW - 20, 0, 20, L.worldH });
+
+        L.wallRects.push_back({ 300, 800, 1200, 30 });
+        L.wallRects.push_back({ 2100, 800, 1200, 30 });
+        L.wallRects.push_back({ 300, 1600, 1200, 30 });
+        L.wallRects.push_back({ 2100, 1600, 1200, 30 });
+        L.wallRects.push_back({ 1785, 300, 30, 600 });
+        L.wallRects.push_back({ 1785, 1500, 30, 600 });
+
+        // Jittered grid of sevens, skipping anything too close to a wall
+        std::uint32_t seed = 67;
+        auto jitter = [&]() {
+            seed = seed * 1664525u + 1013904223u;
+            return static_cast<float>((seed >> 8) % 1000) / 1000.f - 0.5f;
+            };
+        for (int row = 0; row < 12; ++row) {
+            for (int col = 0; col < 20; ++col) {
+                sf::Vector2f p = { 95.f + col * 180.f, 110.f + row * 198.f };
+                p.x += jitter() * 90.f;
+                p.y += jitter() * 90.f;
+
+                bool clear = true;
+                for (const auto& r : L.wallRects) {
+                    if (circleIntersectsRect(p, 45.f, sf::FloatRect({ r.x, r.y }, { r.w, r.h }))) clear = false;
+                }
+                if (clear && circleIntersectsCircle(p, 20.f, L.playerSpawn, 60.f)) clear = false;
+                if (clear) L.targetSpawns.push_back(p);
+            }
+        }
+
+        L.powerups.push_back({ PowerType::Arrow,   { 1700.f, 1200.f }, true });
+        L.powerups.push_back({ PowerType::Speed,   { 1900.f, 1200.f }, true });
+        L.powerups.push_back({ PowerType::AddTime, { 600.f,  1200.f }, true });
+        L.powerups.push_back({ PowerType::AddTime, { 3000.f, 1200.f }, true });
+
+        levels.push_back(std::move(L));
+    }
+
     return levels;
 }
 
+// Big scattered level for cache-behaviour benchmarks. Walls come out in
+// random order, as they would from a hand-edited or imported map.
+static LevelDef makeStressLevel(int wallCount, float size, std::uint32_t seed) {
+    LevelDef L;
+    L.name = "Stress";
+    L.worldW = size;
+    L.worldH = size;
+    L.playerSpawn = { size * 0.5f, size * 0.5f };
+    L.wallRects.push_back({ 0, 0, size, 20 });
+    L.wallRects.push_back({ 0, size - 20, size, 20 });
+    L.wallRects.push_back({ 0, 0, 20, size });
+    L.wallRects.push_back({ size - 20, 0, 20, size });
+
+    std::uint32_t rng = seed;
+    auto next01 = [&]() { rng = rng * 1664525u + 1013904223u; return (rng >> 8) / 16777216.f; };
+    for (int i = 0; i < wallCount; ++i) {
+        float w = 30.f + next01() * 120.f;
+        float h = 30.f + next01() * 120.f;
+        L.wallRects.push_back({ 20.f + next01() * (size - 40.f - w), 20.f + next01() * (size - 40.f - h), w, h });
+    }
+    for (int i = 0; i < wallCount / 20; ++i) {
+        sf::Vector2f c(60.f + next01() * (size - 120.f), 60.f + next01() * (size - 120.f));
+        if (i % 2) L.circles.push_back({ c, 15.f + next01() * 25.f });
+        else L.polygons.push_back(makeRegularPoly(c, 20.f + next01() * 30.f, 5 + i % 3, next01() * 6.28f));
+    }
+    return L;
+}
+
+// Fixed, open probe positions so every run measures the same work
+static std::vector<sf::Vector2f> makeBenchProbes(const LevelDef& L, const WorldGeometry& world, std::size_t count, float radius, std::uint32_t seed) {
+    std::vector<sf::Vector2f> probes;
+    std::uint32_t rng = seed;
+    auto next01 = [&]() { rng = rng * 1664525u + 1013904223u; return (rng >> 8) / 16777216.f; };
+    for (std::size_t tries = 0; probes.size() < count && tries < count * 50; ++tries) {
+        sf::Vector2f p(next01() * L.worldW, next01() * L.worldH);
+        if (!world.circleBlocked(p, radius)) probes.push_back(p);
+    }
+    if (probes.empty()) probes.push_back(L.playerSpawn);
+    return probes;
+}
+
+// A player-like path: from each start, 'steps' moves of 'stride' px that
+// turn away from walls instead of entering them.
+static std::vector<sf::Vector2f> makeBenchWalk(const WorldGeometry& world, const std::vector<sf::Vector2f>& starts, int steps, float stride, float radius, std::uint32_t seed) {
+    std::vector<sf::Vector2f> walk;
+    std::uint32_t rng = seed;
+    auto next01 = [&]() { rng = rng * 1664525u + 1013904223u; return (rng >> 8) / 16777216.f; };
+    for (sf::Vector2f p : starts) {
+        float heading = next01() * 6.2831853f;
+        for (int k = 0; k < steps; ++k) {
+            sf::Vector2f step(std::cos(heading) * stride, std::sin(heading) * stride);
+            if (world.circleBlocked(p + step, radius)) { heading += 1.3f; continue; }
+            p += step;
+            walk.push_back(p);
+        }
+    }
+    if (walk.empty()) walk = starts;
+    return walk;
+}
+
+// ---------------- Micro-benchmarks ----------------
+// --bench runs the geometry hot paths over every level without opening a
+// window. --bench-save <file> writes the results as a baseline,
+// --bench-compare <file> diffs against one (exit code 1 on regressions).
+static int runMicroBenchmarks(const std::vector<LevelDef>& levels, int argc, char** argv) {
+    std::string savePath, comparePath;
+    double thresholdPct = 5.0;
+    int repeats = 15;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--bench-save" && i + 1 < argc) savePath = argv[++i];
+        else if (a == "--bench-compare" && i + 1 < argc) comparePath = argv[++i];
+        else if (a == "--bench-threshold" && i + 1 < argc) thresholdPct = std::atof(argv[++i]);
+        else if (a == "--bench-repeats" && i + 1 < argc) repeats = std::max(2, std::atoi(argv[++i]));
+    }
+
+    const float PROBE_RADIUS = 22.f;   // player size
+    const float LIGHT_RANGE = 215.f;
+    const int PROBES = 256;
+
+    std::vector<BenchStats> results;
+    float sink = 0.f;   // keeps the optimizer from dropping the work
+
+    for (std::size_t li = 0; li < levels.size(); ++li) {
+        const LevelDef& L = levels[li];
+        WorldGeometry world;
+        buildLevelGeometry(L, world);
+
+        std::vector<sf::Vector2f> probes = makeBenchProbes(L, world, PROBES, PROBE_RADIUS, 12345u + static_cast<std::uint32_t>(li));
+
+        std::string prefix = "L" + std::to_string(li + 1) + "/";
+        results.push_back(runBench(prefix + "visibility", repeats, PROBES, [&](int i) {
+            sink += static_cast<float>(computeVisibilityPolygon(probes[i % probes.size()], world, LIGHT_RANGE).size());
+            }));
+
+        // Frame after frame along a walk: from scratch vs. kinetic updates
+        std::vector<sf::Vector2f> walk = makeBenchWalk(world, probes, 64, 3.f, PROBE_RADIUS, 777u + static_cast<std::uint32_t>(li));
+        const int WALK = static_cast<int>(walk.size());
+        results.push_back(runBench(prefix + "visibility-walk", repeats, WALK, [&](int i) {
+            sink += static_cast<float>(computeVisibilityPolygon(walk[i], world, LIGHT_RANGE).size());
+            }));
+        KineticVisibility kinetic;
+        results.push_back(runBench(prefix + "visibility-walk-kinetic", repeats, WALK, [&](int i) {
+            sink += static_cast<float>(kinetic.update(world, walk[i], LIGHT_RANGE).size());
+            }));
+        std::printf("L%zu: kinetic walk %.1f certificates checked, %.1f events, %.1f of %.1f rays traced per frame, rebuilt every %.0f frames\n", li + 1,
+            static_cast<double>(kinetic.stats().totalChecked) / kinetic.stats().frames,
+            static_cast<double>(kinetic.stats().totalSwaps) / kinetic.stats().frames,
+            static_cast<double>(kinetic.stats().totalRetraced) / kinetic.stats().frames,
+            static_cast<double>(kinetic.stats().totalRays) / kinetic.stats().frames,
+            static_cast<double>(kinetic.stats().frames) / std::max<std::uint64_t>(1, kinetic.stats().rebuilds));
+
+        // Any-angle routes between probe pairs over the level's path graph
+        PathGraph paths;
+        paths.build(world, { L.worldW, L.worldH }, PROBE_RADIUS);
+        std::vector<sf::Vector2f> route;
+        PathGraph::Search search;
+        // makeBenchProbes may come back short (down to just the spawn)
+        const int QUERIES = std::max(1, static_cast<int>(probes.size() / 2));
+        results.push_back(runBench(prefix + "path-query", repeats, QUERIES, [&](int i) {
+            paths.findPath(probes[(2 * i) % probes.size()], probes[(2 * i + 1) % probes.size()], route, search);
+            sink += static_cast<float>(route.size());
+            }));
+        std::printf("L%zu: path graph %zu nodes, %zu edges, built in %.1f ms\n", li + 1,
+            paths.stats().nodes, paths.stats().edges, paths.stats().buildMs);
+
+        results.push_back(runBench(prefix + "collision", repeats, PROBES * 64, [&](int i) {
+            const sf::Vector2f& p = probes[(i >> 6) % probes.size()];
+            sf::Vector2f step(((i & 7) - 3.5f) * 4.f, (((i >> 3) & 7) - 3.5f) * 4.f);
+            sink += world.circleBlocked(p + step, PROBE_RADIUS) ? 1.f : 0.f;
+            }));
+        results.push_back(runBench(prefix + "raycast", repeats, PROBES * 64, [&](int i) {
+            float ang = (i & 63) * (6.2831853f / 64.f);
+            sink += world.raycast(probes[(i >> 6) % probes.size()], { std::cos(ang), std::sin(ang) }, LIGHT_RANGE);
+            }));
+
+        // A whole 64-ray fan per op, one ray at a time vs. eight 8-ray packets
+        sf::Vector2f fan[64];
+        for (int k = 0; k < 64; ++k) fan[k] = { std::cos(k * (6.2831853f / 64.f)), std::sin(k * (6.2831853f / 64.f)) };
+        results.push_back(runBench(prefix + "fan64", repeats, PROBES, [&](int i) {
+            for (int k = 0; k < 64; ++k) sink += world.raycast(probes[i % probes.size()], fan[k], LIGHT_RANGE);
+            }));
+        results.push_back(runBench(prefix + "fan64-packet", repeats, PROBES, [&](int i) {
+            float dist[64];
+            world.raycastPacket(probes[i % probes.size()], fan, 64, LIGHT_RANGE, dist);
+            for (int k = 0; k < 64; ++k) sink += dist[k];
+            }));
+
+        // Same queries against 16-bit chunk-local edges
+        WorldGeometry qworld;
+        qworld.quantizeEdges = true;
+        buildLevelGeometry(L, qworld);
+        results.push_back(runBench(prefix + "visibility-q16", repeats, PROBES, [&](int i) {
+            sink += static_cast<float>(computeVisibilityPolygon(probes[i % probes.size()], qworld, LIGHT_RANGE).size());
+            }));
+        results.push_back(runBench(prefix + "raycast-q16", repeats, PROBES * 64, [&](int i) {
+            float ang = (i & 63) * (6.2831853f / 64.f);
+            sink += qworld.raycast(probes[(i >> 6) % probes.size()], { std::cos(ang), std::sin(ang) }, LIGHT_RANGE);
+            }));
+        std::printf("L%zu: %zu edges, %zu bytes as floats, %zu bytes quantized (%zu chunks)\n", li + 1,
+            world.edgeCount(), world.edgeBytes(), qworld.edgeBytes(), qworld.qedges.chunkCount());
+
+        // Level switch: rebuild the geometry on the heap vs. into a rewound arena
+        results.push_back(runBench(prefix + "load-heap", repeats, 16, [&](int) {
+            WorldGeometry g;
+            buildLevelGeometry(L, g);
+            sink += static_cast<float>(g.edgeCount());
+            }));
+        LevelArena arena;
+        results.push_back(runBench(prefix + "load-arena", repeats, 16, [&](int) {
+            WorldGeometry g(&arena);
+            buildLevelGeometry(L, g);
+            sink += static_cast<float>(g.edgeCount());
+            g.clear();
+            arena.release();
+            }));
+        {
+            WorldGeometry g(&arena);
+            buildLevelGeometry(L, g);
+            PathGraph p(&arena);
+            p.build(g, { L.worldW, L.worldH }, PROBE_RADIUS);
+            SimLevel s(&arena);
+            s.build(L, g);
+            std::printf("L%zu: level arena %zu bytes in %zu allocations\n", li + 1, arena.used(), arena.count());
+            s.clear();
+            p.clear();
+            g.clear();
+            arena.release();
+        }
+
+        // Rollback budget: restore a snapshot and re-simulate 8 two-player ticks
+        SimLevel simLevel;
+        simLevel.build(L, world);
+        GameState start = makeInitialState(simLevel, 2);
+        results.push_back(runBench(prefix + "rollback8", repeats, 2048, [&](int i) {
+            GameState s = start;
+            for (int t = 0; t < 8; ++t) {
+                std::uint8_t in[2] = { static_cast<std::uint8_t>((i + t) & 15), static_cast<std::uint8_t>((i * 7 + t) & 15) };
+                simStep(simLevel, s, in, SIM_TICK_DT);
+            }
+            sink += s.players[0].pos.x;
+            }));
+    }
+
+    // Large generated level in authoring order vs. BVH-leaf / Morton order.
+    // Cache misses per ray come from the hardware counters when available.
+    {
+        LevelDef big = makeStressLevel(20000, 24000.f, 777u);
+        PerfCounterGroup perf;
+        bool havePerf = perf.open();
+        for (bool ordered : { false, true }) {
+            WorldGeometry world;
+            world.spatialOrder = ordered;
+            buildLevelGeometry(big, world);
+            std::vector<sf::Vector2f> probes = makeBenchProbes(big, world, PROBES * 4, PROBE_RADIUS, 4242u);
+            auto ray = [&](int i) {
+                float ang = (i & 63) * (6.2831853f / 64.f);
+                sink += world.raycast(probes[(i >> 6) % probes.size()], { std::cos(ang), std::sin(ang) }, LIGHT_RANGE);
+                };
+
+            std::string prefix = ordered ? "GEN/morton-" : "GEN/authored-";
+            results.push_back(runBench(prefix + "visibility", repeats, PROBES * 4, [&](int i) {
+                sink += static_cast<float>(computeVisibilityPolygon(probes[i % probes.size()], world, LIGHT_RANGE).size());
+                }));
+            results.push_back(runBench(prefix + "raycast", repeats, PROBES * 256, ray));
+
+            if (havePerf) {
+                const int RAYS = PROBES * 256;
+                PerfSample ps;
+                {
+                    PerfZone zone(&perf, ps);
+                    for (int i = 0; i < RAYS; ++i) ray(i);
+                }
+                std::printf("%-34s %.3f cache misses / ray, IPC %.2f\n", (prefix + "raycast").c_str(),
+                    static_cast<double>(ps.cacheMisses) / RAYS, ps.ipc());
+            }
+        }
+    }
+    std::printf("(checksum %.1f)\n", sink);
+
+    printBenchTable(results);
+    if (!savePath.empty() && saveBaseline(savePath, results)) {
+        std::cout << "Baseline saved to " << savePath << "\n";
+    }
+    if (!comparePath.empty()) {
+        std::vector<BenchStats> baseline;
+        if (!loadBaseline(comparePath, baseline)) return 2;
+        std::cout << "\nAgainst " << comparePath << " (regression threshold " << thresholdPct << "%):\n";
+        int regressions = printComparison(baseline, results, thresholdPct);
+        if (regressions > 0) {
+            std::cout << regressions << " regression(s).\n";
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// ---------------- Flythrough path ----------------
+// Serpentine sweep over the map, rows 'spacing' apart, keeping only the
+// waypoints the player could stand on. Starts at the spawn. Consecutive
+// waypoints are joined by a route the player could walk, so the light never
+// passes through a wall; one that can't be reached is skipped.
+static std::vector<sf::Vector2f> buildFlythroughPath(const LevelDef& L, const WorldGeometry& world, const PathGraph& paths, float spacing, float radius) {
+    std::vector<sf::Vector2f> path{ L.playerSpawn };
+    std::vector<sf::Vector2f> route;
+    PathGraph::Search search;
+    int rows = std::max(1, (int)(L.worldH / spacing));
+    int cols = std::max(1, (int)(L.worldW / spacing));
+    for (int r = 0; r < rows; ++r) {
+        float y = (r + 0.5f) * L.worldH / rows;
+        for (int k = 0; k < cols; ++k) {
+            int c = (r % 2 == 0) ? k : cols - 1 - k;
+            sf::Vector2f p((c + 0.5f) * L.worldW / cols, y);
+            if (world.circleBlocked(p, radius)) continue;
+            if (paths.findPath(path.back(), p, route, search)) path.insert(path.end(), route.begin(), route.end());
+            else if (world.hasClearPath(path.back(), p, radius)) path.push_back(p);   // no graph on this level
+        }
+    }
+    return path;
+}
+
+// ---------------- Headless server ----------------
+// --server <matches> hosts bot-driven matches without a window.
+// --server-threads <n> (default: all cores), --server-seconds <s>,
+// --server-level <n> (default: round-robin over every level),
+// --server-unthrottled ticks as fast as possible to measure capacity.
+static int runServer(const std::vector<LevelDef>& levels, int argc, char** argv) {
+    MatchServer::Config cfg;
+    int onlyLevel = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--server" && i + 1 < argc) cfg.matches = std::max(1, std::atoi(argv[++i]));
+        else if (a == "--server-threads" && i + 1 < argc) cfg.threads = std::max(0, std::atoi(argv[++i]));
+        else if (a == "--server-seconds" && i + 1 < argc) cfg.seconds = std::max(1.f, (float)std::atof(argv[++i]));
+        else if (a == "--server-level" && i + 1 < argc) onlyLevel = std::atoi(argv[++i]);
+        else if (a == "--server-unthrottled") cfg.unthrottled = true;
+    }
+
+    // One immutable instance per level, shared by every match that plays it
+    std::vector<std::shared_ptr<const SharedLevel>> shared;
+    for (int i = 0; i < (int)levels.size(); ++i) {
+        if (onlyLevel > 0 && i + 1 != onlyLevel) continue;
+        shared.push_back(std::make_shared<const SharedLevel>(levels[i], SimTuning{}));
+    }
+    if (shared.empty()) {
+        std::cout << "No level " << onlyLevel << " (have " << levels.size() << ").\n";
+        return 2;
+    }
+
+    MatchServer server(std::move(shared), cfg);
+    server.run();
+    return 0;
+}
+
+// ---------------- Rollback check ----------------
+// --rollback-check: two sessions in this process race over loopback with
+// scripted inputs and uneven pacing (0-2 ticks per side per frame), match
+// after match until 3000 ticks have been confirmed. Both sides must end on
+// the same confirmed state as a straight simStep() run of the same inputs.
+// Uses --versus-level and --versus-port like a real race.
+static int runRollbackCheck(const std::vector<LevelDef>& levels, int argc, char** argv) {
+    const std::uint32_t CHECK_TICKS = 3000;
+    int levelIndex = 1;
+    unsigned short port = 47600;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--versus-level" && i + 1 < argc) levelIndex = std::atoi(argv[++i]);
+        else if (a == "--versus-port" && i + 1 < argc) port = static_cast<unsigned short>(std::atoi(argv[++i]));
+    }
+    const LevelDef& L = levels[std::clamp(levelIndex, 1, (int)levels.size()) - 1];
+    WorldGeometry world;
+    buildLevelGeometry(L, world);
+    SimLevel level;
+    level.build(L, world, SimTuning{});
+
+    // A new direction every 20 ticks, so predictions keep going wrong
+    auto scripted = [](int player, std::uint32_t tick, int match) {
+        std::uint32_t h = (tick / 20u + 1u) * 0x9E3779B9u ^ (static_cast<std::uint32_t>(player) + 1u) * 0x85EBCA6Bu ^ static_cast<std::uint32_t>(match) * 0xC2B2AE35u;
+        h ^= h >> 15;
+        h *= 0x2C1B3C6Du;
+        h ^= h >> 12;
+        return static_cast<std::uint8_t>(h & 15u);
+        };
+    std::uint32_t pacing = 0x12345678u;
+    auto nextPacing = [&]() { pacing ^= pacing << 13; pacing ^= pacing >> 17; pacing ^= pacing << 5; return pacing; };
+
+    std::uint32_t checkedTicks = 0;
+    int match = 0, failures = 0;
+    std::uint64_t rollbacks = 0;
+    while (checkedTicks < CHECK_TICKS) {
+        RollbackSession sides[2];
+        if (!sides[0].start(level, 0, port, static_cast<unsigned short>(port + 1)) ||
+            !sides[1].start(level, 1, static_cast<unsigned short>(port + 1), port)) return 2;
+
+        for (int frame = 0; frame < 100000 && !(sides[0].finished() && sides[1].finished()); ++frame) {
+            for (int p = 0; p < 2; ++p) {
+                RollbackSession& s = sides[p];
+                if (s.finished()) { s.poll(); continue; }
+                for (std::uint32_t k = nextPacing() % 3; k > 0; --k) {
+                    if (!s.advance(scripted(p, s.tick(), match))) break;
+                }
+            }
+        }
+        for (int k = 0; k < 100; ++k) {
+            bool pending = sides[0].poll();
+            pending = sides[1].poll() || pending;
+            if (!pending) break;
+        }
+
+        GameState ref = makeInitialState(level, 2);
+        while (ref.status == SimStatus::Playing) {
+            std::uint8_t in[2] = { scripted(0, ref.tick, match), scripted(1, ref.tick, match) };
+            simStep(level, ref, in, SIM_TICK_DT);
+        }
+        std::uint64_t want = replay::hashState(ref);
+        bool ok = sides[0].finished() && sides[1].finished() &&
+            replay::hashState(sides[0].confirmedState()) == want && replay::hashState(sides[1].confirmedState()) == want;
+        if (!ok) failures++;
+        rollbacks += sides[0].getStats().rollbacks + sides[1].getStats().rollbacks;
+        std::printf("match %d: %u ticks, %s, %llu + %llu rollbacks\n", match + 1, ref.tick, ok ? "identical" : "MISMATCH",
+            static_cast<unsigned long long>(sides[0].getStats().rollbacks), static_cast<unsigned long long>(sides[1].getStats().rollbacks));
+        checkedTicks += ref.tick;
+        match++;
+    }
+    std::printf("Rollback check: %u ticks in %d matches, %llu rollbacks, %d mismatches\n",
+        checkedTicks, match, static_cast<unsigned long long>(rollbacks), failures);
+    return failures == 0 ? 0 : 1;
+}
+
+// ---------------- Replays ----------------
+// --verify-replays <file or dir>... re-simulates every replay and checks its
+// claim; directories contribute their *.mgrp files. --make-replays <dir>
+// writes bot runs of every level, as a corpus for the verifier.
+static int runReplayTool(const std::vector<LevelDef>& levels, int argc, char** argv) {
+    replay::BatchVerifier::Config cfg;
+    std::vector<std::string> files;
+    std::string makeDir;
+    int perLevel = 4;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--verify-replays") {
+            while (i + 1 < argc && std::string(argv[i + 1]).rfind("--", 0) != 0) {
+                std::filesystem::path path(argv[++i]);
+                std::error_code ec;
+                if (std::filesystem::is_directory(path, ec)) {
+                    std::vector<std::string> found;
+                    for (const auto& e : std::filesystem::directory_iterator(path, ec)) {
+                        if (e.path().extension() == ".mgrp") found.push_back(e.path().string());
+                    }
+                    std::sort(found.begin(), found.end());
+                    files.insert(files.end(), found.begin(), found.end());
+                }
+                else files.push_back(path.string());
+            }
+        }
+        else if (a == "--verify-threads" && i + 1 < argc) cfg.threads = std::max(0, std::atoi(argv[++i]));
+        else if (a == "--verify-verbose") cfg.verbose = true;
+        else if (a == "--make-replays" && i + 1 < argc) makeDir = argv[++i];
+        else if (a == "--make-replays-count" && i + 1 < argc) perLevel = std::max(1, std::atoi(argv[++i]));
+    }
+
+    if (!makeDir.empty()) {
+        // Single-player bot runs at fixed ticks; only cleared runs are kept
+        int written = 0;
+        for (std::size_t li = 0; li < levels.size(); ++li) {
+            SharedLevel level(levels[li], SimTuning{});
+            for (int run = 0; run < perLevel; ++run) {
+                replay::Replay r;
+                r.levelName = levels[li].name;
+                r.level = replay::levelFingerprint(levels[li], level.sim.tune);
+                GameState s = makeInitialState(level.sim, 1);
+                BotBrain bot;
+                bot.rng = 0x9E3779B9u * static_cast<std::uint32_t>(li * 131 + run + 1);
+                while (s.status == SimStatus::Playing && r.ticks < replay::MAX_TICKS) {
+                    std::uint8_t in = bot.think(level.sim, level.paths, s, 0);
+                    r.record(&in);
+                    simStep(level.sim, s, &in, SIM_TICK_DT);
+                }
+                if (s.status != SimStatus::Cleared) continue;
+                r.finalHash = replay::hashState(s);
+                std::string path = makeDir + "/level" + std::to_string(li + 1) + "-" + std::to_string(run + 1) + ".mgrp";
+                if (replay::saveReplay(path, r)) written++;
+            }
+        }
+        std::cout << "Wrote " << written << " replays to " << makeDir << "\n";
+        if (files.empty()) return written > 0 ? 0 : 1;
+    }
+
+    if (files.empty()) {
+        std::cout << "No replays to verify.\n";
+        return 2;
+    }
+    replay::BatchVerifier verifier(levels, cfg);
+    return verifier.run(files) == 0 ? 0 : 1;
+}
+
+// ---------------- Self-test ----------------
+// --selftest: every built-in level (and a generated many-chunk one) must come
+// back from a .mglv save / load with each coordinate on the nearest fixed-point
+// step and save again to the same bytes, and damaged .mglv images - cut
+// short anywhere in the header and at steps through the payload, or with a
+// single bit flipped - must be refused. The .mglt text of each level must
+// parse back to exactly the same level, and malformed text must be refused
+// at the right line and column. Exits nonzero on any failure.
+
+// Silences std::cout while a check feeds a loader input it is meant to refuse.
+struct MuteCout {
+    std::ostringstream sink;
+    std::streambuf* old = std::cout.rdbuf(sink.rdbuf());
+    ~MuteCout() { std::cout.rdbuf(old); }
+};
+
+// The binary format regroups objects by chunk, so compare per-kind lists in
+// one canonical order.
+static LevelDef canonicalLevel(LevelDef L) {
+    auto vecLess = [](sf::Vector2f a, sf::Vector2f b) { return std::tie(a.x, a.y) < std::tie(b.x, b.y); };
+    std::sort(L.wallRects.begin(), L.wallRects.end(), [](const RectF& a, const RectF& b) { return std::tie(a.x, a.y, a.w, a.h) < std::tie(b.x, b.y, b.w, b.h); });
+    std::sort(L.targetSpawns.begin(), L.targetSpawns.end(), vecLess);
+    std::sort(L.powerups.begin(), L.powerups.end(), [](const PowerUp& a, const PowerUp& b) { return std::tie(a.type, a.pos.x, a.pos.y) < std::tie(b.type, b.pos.x, b.pos.y); });
+    std::sort(L.circles.begin(), L.circles.end(), [](const CircleObstacle& a, const CircleObstacle& b) { return std::tie(a.c.x, a.c.y, a.r) < std::tie(b.c.x, b.c.y, b.r); });
+    std::sort(L.polygons.begin(), L.polygons.end(), [&](const ConvexPoly& a, const ConvexPoly& b) {
+        return std::lexicographical_compare(a.pts.begin(), a.pts.end(), b.pts.begin(), b.pts.end(), vecLess);
+        });
+    return L;
+}
+
+// Field by field, in order, coordinates to within 'tol'; "" when equal,
+// else the first field that differs.
+static std::string levelDifference(const LevelDef& a, const LevelDef& b, float tol) {
+    auto near = [tol](float l, float r) { return std::fabs(l - r) <= tol; };
+    auto vecNear = [&](sf::Vector2f l, sf::Vector2f r) { return near(l.x, r.x) && near(l.y, r.y); };
+    auto rectNear = [&](const RectF& l, const RectF& r) { return near(l.x, r.x) && near(l.y, r.y) && near(l.w, r.w) && near(l.h, r.h); };
+    auto powerNear = [&](const PowerUp& l, const PowerUp& r) { return l.type == r.type && vecNear(l.pos, r.pos) && l.active == r.active; };
+    auto circleNear = [&](const CircleObstacle& l, const CircleObstacle& r) { return vecNear(l.c, r.c) && near(l.r, r.r); };
+    auto polyNear = [&](const ConvexPoly& l, const ConvexPoly& r) { return std::ranges::equal(l.pts, r.pts, vecNear); };
+    if (a.name != b.name) return "name";
+    if (!near(a.worldW, b.worldW) || !near(a.worldH, b.worldH)) return "world";
+    if (!vecNear(a.playerSpawn, b.playerSpawn)) return "spawn";
+    if (a.timeLimit != b.timeLimit) return "timeLimit";
+    if (a.tileSize != b.tileSize || a.tileRows != b.tileRows) return "tiles";
+    if (!std::ranges::equal(a.targetSpawns, b.targetSpawns, vecNear)) return "targets";
+    if (!std::ranges::equal(a.wallRects, b.wallRects, rectNear)) return "walls";
+    if (!std::ranges::equal(a.powerups, b.powerups, powerNear)) return "powerups";
+    if (!std::ranges::equal(a.circles, b.circles, circleNear)) return "circles";
+    if (!std::ranges::equal(a.polygons, b.polygons, polyNear)) return "polygons";
+    return "";
+}
+
+static int runSelfTest(std::vector<LevelDef> levels) {
+    levels.push_back(makeStressLevel(3000, 9000.f, 4242u));
+    int failures = 0;
+    auto check = [&](bool ok, const LevelDef& L, const std::string& what) {
+        if (ok) return;
+        failures++;
+        std::printf("FAIL %s: %s\n", L.name.c_str(), what.c_str());
+        };
+
+    for (const LevelDef& L : levels) {
+        // Binary: round trip to fixed point, then damaged copies of the image
+        const std::vector<std::uint8_t> image = levelfile::encodeLevelFile(L);
+        LevelDef back;
+        bool same = levelfile::decodeLevelFile(image, L.name, back);
+        check(same, L, "mglv image did not load");
+        if (same) {
+            std::string diff = levelDifference(canonicalLevel(L), canonicalLevel(back), 0.5f / levelfile::FIXED_ONE);
+            check(diff.empty(), L, "mglv round trip moved " + diff);
+            bool stable = levelfile::encodeLevelFile(back) == image;
+            check(stable, L, "mglv image of the loaded level differs");
+            same = diff.empty() && stable;
+        }
+
+        int damaged = 0, refused = 0;
+        auto expectRefused = [&](const std::vector<std::uint8_t>& bytes, const std::string& how) {
+            LevelDef out;
+            bool ok;
+            {
+                MuteCout mute;
+                ok = levelfile::decodeLevelFile(bytes, L.name, out);
+            }
+            damaged++;
+            if (!ok) refused++;
+            check(!ok, L, "mglv " + how + " was accepted");
+            };
+        const std::size_t size = image.size();
+        const std::size_t step = std::max<std::size_t>(1, size / 64);
+        for (std::size_t cut = 0; cut < size; cut += cut < 128 ? 1 : step) {
+            expectRefused(std::vector<std::uint8_t>(image.begin(), image.begin() + static_cast<std::ptrdiff_t>(cut)),
+                "cut to " + std::to_string(cut) + " bytes");
+        }
+        for (std::size_t at = 0; at < size; at += std::max<std::size_t>(1, size / 97)) {
+            std::vector<std::uint8_t> flipped = image;
+            flipped[at] ^= static_cast<std::uint8_t>(1u << (at % 8));
+            expectRefused(flipped, "bit " + std::to_string(at % 8) + " of byte " + std::to_string(at) + " flipped");
+        }
+        std::printf("%-16s mglv %zu bytes: round trip %s, %d of %d damaged images refused\n",
+            L.name.c_str(), size, same ? "ok" : "FAILED", refused, damaged);
+
+        // Text: bit-exact round trip, in order
+        const std::string text = leveltext::formatLevelText(L);
+        LevelDef parsed;
+        leveltext::ParseError err;
+        bool exact = leveltext::parseLevelText(text, parsed, &err);
+        check(exact, L, "mglt text did not parse: " + std::to_string(err.line) + ":" + std::to_string(err.column) + ": " + err.message);
+        if (exact) {
+            std::string diff = levelDifference(L, parsed, 0.f);
+            check(diff.empty(), L, "mglt round trip changed " + diff);
+            exact = diff.empty() && leveltext::formatLevelText(parsed) == text;
+            check(exact, L, "mglt text of the parsed level differs");
+        }
+        std::printf("%-16s mglt %zu bytes: round trip %s\n", L.name.c_str(), text.size(), exact ? "ok" : "FAILED");
+    }
+
+    // Malformed text: where the parser must point, and what it must say
+    struct BadText {
+        const char* text;
+        int line, column;
+        const char* message;
+    };
+    const BadText badTexts[] = {
+        { "{\n  name: \"A\",\n  world: [100, nan],\n  spawn: [1, 1]\n}", 3, 16, "number must be finite" },
+        { "{ name: \"A\", world: [100, 100],\n  spawn: [-inf, 1] }", 2, 11, "number must be finite" },
+        { "{ name: \"A\", world: [100, 100], spawn: [1, 1],\n  timeLimit: 1e39 }", 2, 14, "number out of range" },
+        { "{ name: \"A\", colour: 3 }", 1, 14, "unknown key 'colour'" },
+        { "{\n  name: \"A\n}", 2, 11, "unterminated string" },
+        { "{ name: \"A\",\n  world: [1, 2, 3] }", 2, 17, "expected 2 numbers" },
+        { "{ name: \"A\", world: [100, 100] }", 1, 1, "missing 'spawn'" },
+        { "// header\n{ name: \"A\", world: [100, 100], spawn: [1, 1]\n  walls: [] }", 3, 3, "expected ',' or '}'" },
+        { "{ name: \"A\", world: [100, 100], spawn: [1, 1],\n  polygons: [[[0, 0], [1, 1]]] }", 2, 14, "at least 3 points" },
+        { "{ name: \"A\", world: [100, 100], spawn: [1, 1],\n  powerups: [{ type: \"Fly\", pos: [1, 1] }] }", 2, 22, "unknown powerup type 'Fly'" },
+        { "{ name: \"A\", world: [100, 100], spawn: [1, 1] } x", 1, 49, "unexpected text after the level" },
+    };
+    int refusedTexts = 0;
+    for (const BadText& b : badTexts) {
+        LevelDef out;
+        leveltext::ParseError err;
+        bool ok = leveltext::parseLevelText(b.text, out, &err);
+        bool right = !ok && err.line == b.line && err.column == b.column && err.message.find(b.message) != std::string::npos;
+        if (right) { refusedTexts++; continue; }
+        failures++;
+        std::printf("FAIL mglt: wanted %d:%d: %s, got %s\n", b.line, b.column, b.message,
+            ok ? "no error" : (std::to_string(err.line) + ":" + std::to_string(err.column) + ": " + err.message).c_str());
+    }
+    std::printf("Malformed mglt: %d of %zu refused at the right place\n", refusedTexts, std::size(badTexts));
+
+    std::printf("Self-test: %zu levels, %d failures\n", levels.size(), failures);
+    return failures == 0 ? 0 : 1;
+}
+
 // ---------------- Powerup visuals ----------------
 static sf::Color powerColor(PowerType t) {
     switch (t) {
@@ -500,12 +1258,15 @@ static void drawArrowToTarget(sf::RenderTarget& target, sf::Vector2f from, sf::V
 }
 
 // ---------------- Main ----------------
-int main() {
+int main(int argc, char** argv) {
     const unsigned W = 900;
     const unsigned H = 650;
 
-    const float PLAYER_RADIUS = 22.f;
-    const float TARGET_RADIUS = 18.f;
+    // Gameplay tuning comes from SimTuning, which replays are verified
+    // against; the names below are what the drawing code reads
+    const SimTuning tuning{};
+    const float PLAYER_RADIUS = tuning.playerRadius;
+    const float TARGET_RADIUS = tuning.targetRadius;
 
     // Anim
     const float ANIM_FPS = 6.f;
@@ -517,30 +1278,145 @@ int main() {
     const sf::Color WARM_TINT(255, 190, 140, 255);
     float glowStrength = 120.f;
 
-    // Base gameplay
-    const float BASE_SPEED = 320.f;
-
-    // Powerup tuning (easy knobs)
-    const float PWR_RADIUS = 16.f;
-    const float TIME_ADD_SECONDS = 6.f;
-
-    const float SPEED_MULT = 1.55f;
-    const float SPEED_DURATION = 5.f;
-
-    const float ARROW_DURATION = 6.f;
-    const float FULLLIGHT_DURATION = 5.f;
+    // Powerups
+    const float PWR_RADIUS = tuning.powerupRadius;
 
     // Levels
     std::vector<LevelDef> levels = makeLevels();
+
+    // --export-levels <dir> writes the built-in levels as .mglv files
+    // (--export-levels-text: as .mglt text); --level-file <path> (repeatable)
+    // adds a level from either kind to the menu; --level-dir <dir> adds every
+    // .mglt level in a directory.
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if ((a == "--export-levels" || a == "--export-levels-text") && i + 1 < argc) {
+            const bool text = a == "--export-levels-text";
+            std::string dir = argv[++i];
+            int failed = 0;
+            for (std::size_t li = 0; li < levels.size(); ++li) {
+                std::string path = dir + "/level" + std::to_string(li + 1) + (text ? ".mglt" : ".mglv");
+                bool ok = text ? leveltext::saveLevelText(path, levels[li]) : levelfile::saveLevelFile(path, levels[li]);
+                if (ok) std::cout << "Wrote " << path << "\n";
+                else failed++;
+            }
+            return failed == 0 ? 0 : 1;
+        }
+        if (a == "--level-file" && i + 1 < argc) {
+            LevelDef L;
+            std::string path = argv[++i];
+            if (std::filesystem::path(path).extension() == ".mglt") {
+                leveltext::LoadStats st;
+                if (leveltext::loadLevelText(path, L, &st)) {
+                    std::cout << "Loaded " << path << " (" << L.name << "): " << st.fileBytes << " bytes parsed in " << st.parseMs << " ms\n";
+                    levels.push_back(std::move(L));
+                }
+                continue;
+            }
+            levelfile::LoadStats st;
+            if (levelfile::loadLevelFile(path, L, 0, &st)) {
+                std::cout << "Loaded " << path << " (" << L.name << "): " << st.fileBytes << " bytes, "
+                    << st.chunks << " chunks on " << st.threads << " threads in " << st.decodeMs << " ms\n";
+                levels.push_back(std::move(L));
+            }
+        }
+        if (a == "--level-dir" && i + 1 < argc) {
+            std::vector<std::string> paths;
+            std::error_code ec;
+            for (const auto& e : std::filesystem::directory_iterator(argv[++i], ec)) {
+                if (e.path().extension() == ".mglt") paths.push_back(e.path().string());
+            }
+            std::sort(paths.begin(), paths.end());
+            std::size_t bytes = 0, loaded = 0;
+            auto t0 = std::chrono::steady_clock::now();
+            for (const auto& path : paths) {
+                LevelDef L;
+                leveltext::LoadStats st;
+                if (!leveltext::loadLevelText(path, L, &st)) continue;
+                bytes += st.fileBytes;
+                loaded++;
+                levels.push_back(std::move(L));
+            }
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            std::cout << "Loaded " << loaded << " of " << paths.size() << " levels from " << argv[i] << " ("
+                << bytes / 1024u << " KiB) in " << ms << " ms\n";
+        }
+    }
     const int LEVEL_COUNT = (int)levels.size();
 
-    // Timer per level
-    const float LEVEL_TIME_LIMIT = 30.f;
-    float timeLeft = LEVEL_TIME_LIMIT;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--bench") return runMicroBenchmarks(levels, argc, argv);
+        if (std::string(argv[i]) == "--server") return runServer(levels, argc, argv);
+        if (std::string(argv[i]) == "--rollback-check") return runRollbackCheck(levels, argc, argv);
+        if (std::string(argv[i]) == "--verify-replays" || std::string(argv[i]) == "--make-replays") return runReplayTool(levels, argc, argv);
+        if (std::string(argv[i]) == "--selftest") return runSelfTest(levels);
+    }
+
     sf::Clock clock;
 
+    // Scripted flythrough: --benchmark sweeps the player over every level with
+    // FullLight off and the frame cap removed, then prints whole-frame times.
+    bool flythrough = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--benchmark") flythrough = true;
+    }
+
+    // Two-player rollback race on this machine: run one instance with
+    // --versus 1 and another with --versus 2 (UDP ports base and base+1).
+    int versusPlayer = -1;   // 0-based, -1 = single player
+    unsigned short versusPort = 47600;
+    int versusLevel = 1;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--versus" && i + 1 < argc) versusPlayer = std::clamp(std::atoi(argv[++i]), 1, 2) - 1;
+        else if (a == "--versus-port" && i + 1 < argc) versusPort = static_cast<unsigned short>(std::atoi(argv[++i]));
+        else if (a == "--versus-level" && i + 1 < argc) versusLevel = std::atoi(argv[++i]);
+    }
+
+    // Live metrics: --metrics-socket <path> (or MYGAME_METRICS_SOCKET) starts a
+    // Unix-socket server that answers with the latest snapshot.
+    std::string metricsPath;
+    if (auto env = envVar("MYGAME_METRICS_SOCKET")) metricsPath = *env;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--metrics-socket" && i + 1 < argc) metricsPath = argv[++i];
+    }
+    MetricsServer metrics;
+    if (!metricsPath.empty()) metrics.start(metricsPath);
+
+    // Hardware counters around the visibility zone: --perf-counters (or
+    // MYGAME_PERF_COUNTERS=1). Linux only; shown in F3 and in metrics.
+    bool wantPerf = envVar("MYGAME_PERF_COUNTERS").has_value();
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--perf-counters") wantPerf = true;
+    }
+    PerfCounterGroup perfCounters;
+    if (wantPerf && perfCounters.open()) std::cout << "Perf counters enabled for the visibility zone.\n";
+    PerfCounterGroup* perfZoneGroup = perfCounters.available() ? &perfCounters : nullptr;
+
     sf::RenderWindow window(sf::VideoMode({ W, H }), "67 Hunt");
-    window.setFramerateLimit(120);
+    window.setFramerateLimit(flythrough ? 0 : 120);
+    if (flythrough) window.setVerticalSyncEnabled(false);
+
+    // Sprite textures are streamed through a budgeted cache; game code keeps
+    // handles and re-binds every frame. Frames are decoded and resampled to
+    // their on-screen size (x DPI scale) on the manager's worker thread while
+    // the rest of startup runs.
+    const std::size_t TEXTURE_BUDGET_BYTES = 64u * 1024u * 1024u;
+    TextureManager textures(TEXTURE_BUDGET_BYTES);
+    const float DPI_SCALE = displayScale();
+    auto spritePixels = [&](float diameter) {
+        unsigned px = static_cast<unsigned>(std::lround(diameter * DPI_SCALE));
+        return sf::Vector2u{ px, px };
+        };
+
+    std::vector<TextureHandle> playerFrames;
+    std::vector<TextureHandle> targetFrames;
+    for (int i = 1; i <= FRAME_COUNT; ++i) {
+        playerFrames.push_back(textures.request("assets/sprites/six" + std::to_string(i) + ".png", spritePixels(PLAYER_RADIUS * 2.f)));
+        targetFrames.push_back(textures.request("assets/sprites/seven" + std::to_string(i) + ".png", spritePixels(TARGET_RADIUS * 2.f)));
+        textures.prefetch(playerFrames.back());
+        textures.prefetch(targetFrames.back());
+    }
 
     enum class GameMode { Menu, Playing, Win, Lose };
     GameMode mode = GameMode::Menu;
@@ -551,6 +1427,9 @@ int main() {
     sf::View camera(sf::FloatRect({ 0.f, 0.f }, { (float)W, (float)H }));
 
     // Darkness overlay (screen space RT)
+    // The single-pass mesh is the default; F4 switches back to the RT path
+    // (clear, fill, erase fan, full-screen sprite) for comparison.
+    bool singlePassDarkness = true;
     sf::RenderTexture darknessRT;
     if (!darknessRT.resize({ W, H })) {
         std::cout << "Failed to create darkness render texture.\n";
@@ -558,14 +1437,58 @@ int main() {
     sf::RectangleShape darknessRect({ (float)W, (float)H });
     darknessRect.setFillColor(sf::Color(0, 0, 0, DARK_ALPHA));
 
+    // Everything that lives as long as a level (geometry, path graph, wall
+    // drawables, floor tiles, targets and powerups) comes from one arena,
+    // rewound on each load; --huge-pages
+    // backs it with huge pages where the OS allows.
+    bool hugePages = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--huge-pages") hugePages = true;
+    }
+    LevelArena levelArena(LevelArena::DEFAULT_BYTES, hugePages);
+
+    // Floor tiles (baked per chunk, see FloorLayer)
+    const unsigned FLOOR_TILE_PX = 64;
+    const int FLOOR_VARIANTS = 4;
+    sf::Texture floorAtlas;
+    if (!floorAtlas.loadFromImage(makeFloorAtlas(FLOOR_TILE_PX, FLOOR_VARIANTS))) {
+        std::cout << "Failed to create floor atlas.\n";
+    }
+    FloorLayer floorLayer(&levelArena);
+    floorLayer.setAtlas(&floorAtlas, FLOOR_TILE_PX);
+
+    // Decals stamped into the floor (persist until the level is reloaded)
+    const unsigned DECAL_CELL_PX = 32;
+    const float FOOTPRINT_STRIDE = 28.f;
+    const float FOOTPRINT_SIZE = 16.f;
+    const float SCORCH_SIZE = 70.f;
+    sf::Texture decalAtlas;
+    if (!decalAtlas.loadFromImage(makeDecalAtlas(DECAL_CELL_PX))) {
+        std::cout << "Failed to create decal atlas.\n";
+    }
+    decalAtlas.setSmooth(true);
+    floorLayer.setDecalAtlas(&decalAtlas, DECAL_CELL_PX);
+    float footprintDist = 0.f;
+    bool footprintLeft = false;
+
     // ---------------- Sprites ----------------
+    textures.finishPending();
+
+    // Point a sprite at the current texture behind a handle (it may have
+    // been evicted and reloaded since the last frame).
+    auto bindFrame = [&](sf::Sprite& spr, TextureHandle h, float diameter) {
+        sf::Vector2f keep = spr.getPosition();
+        const sf::Texture& tex = textures.get(h);
+        spr.setTexture(tex, true);
+        fitSpriteToDiameter(spr, tex, diameter);
+        spr.setPosition(keep);
+        };
+
     // Player fallback
     sf::CircleShape playerCircle(PLAYER_RADIUS);
     playerCircle.setOrigin({ PLAYER_RADIUS, PLAYER_RADIUS });
     playerCircle.setFillColor(sf::Color::Cyan);
 
-    std::vector<sf::Texture> playerFrames;
-    playerFrames.reserve(FRAME_COUNT);
     std::optional<sf::Sprite> playerSprite;
 
     int   playerFrame = 0;
@@ -573,19 +1496,16 @@ int main() {
     float frameTime = 1.f / ANIM_FPS;
 
     bool playerFramesOK = true;
-    for (int i = 1; i <= FRAME_COUNT; ++i) {
-        sf::Texture t;
-        std::string path = "assets/sprites/six" + std::to_string(i) + ".png";
-        if (!t.loadFromFile(path)) {
-            std::cout << "Missing player frame: " << path << "\n";
+    for (TextureHandle h : playerFrames) {
+        if (textures.isFailed(h)) {
+            std::cout << "Missing player frame: " << textures.path(h) << "\n";
             playerFramesOK = false;
             break;
         }
-        playerFrames.push_back(std::move(t));
     }
     if (playerFramesOK) {
-        sf::Sprite s(playerFrames[0]);
-        fitSpriteToDiameter(s, playerFrames[0], PLAYER_RADIUS * 2.f);
+        sf::Sprite s(textures.get(playerFrames[0]));
+        bindFrame(s, playerFrames[0], PLAYER_RADIUS * 2.f);
         playerSprite = s;
     }
     else {
@@ -597,27 +1517,22 @@ int main() {
     targetCircle.setOrigin({ TARGET_RADIUS, TARGET_RADIUS });
     targetCircle.setFillColor(sf::Color::Yellow);
 
-    std::vector<sf::Texture> targetFrames;
-    targetFrames.reserve(FRAME_COUNT);
     std::optional<sf::Sprite> targetSprite;
 
     int   targetFrame = 0;
     float targetAnimTimer = 0.f;
 
     bool targetFramesOK = true;
-    for (int i = 1; i <= FRAME_COUNT; ++i) {
-        sf::Texture t;
-        std::string path = "assets/sprites/seven" + std::to_string(i) + ".png";
-        if (!t.loadFromFile(path)) {
-            std::cout << "Missing target frame: " << path << "\n";
+    for (TextureHandle h : targetFrames) {
+        if (textures.isFailed(h)) {
+            std::cout << "Missing target frame: " << textures.path(h) << "\n";
             targetFramesOK = false;
             break;
         }
-        targetFrames.push_back(std::move(t));
     }
     if (targetFramesOK) {
-        sf::Sprite s(targetFrames[0]);
-        fitSpriteToDiameter(s, targetFrames[0], TARGET_RADIUS * 2.f);
+        sf::Sprite s(textures.get(targetFrames[0]));
+        bindFrame(s, targetFrames[0], TARGET_RADIUS * 2.f);
         targetSprite = s;
     }
     else {
@@ -628,16 +1543,62 @@ int main() {
     float WORLD_W = levels[0].worldW;
     float WORLD_H = levels[0].worldH;
 
-    std::vector<sf::RectangleShape> walls;
-    std::vector<Segment> wallSegs;
-
-    // Active powerups for current level
-    std::vector<PowerUp> powerups;
-
-    // Temporary effects state
-    float speedBoostLeft = 0.f;
-    float arrowLeft = 0.f;
-    float fullLightLeft = 0.f;
+    // --record-replays <dir>: single-player runs step at fixed ticks and each
+    // cleared level is saved as a replay for the leaderboard verifier
+    std::string replayDir;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--record-replays" && i + 1 < argc) replayDir = argv[++i];
+    }
+    replay::Replay recording;
+    float replayAccum = 0.f;
+
+    // Collision + light blockers, and what gets drawn for them
+    WorldGeometry world(&levelArena);
+    // --quantize-edges keeps light-blocking edges as 16-bit chunk-local ints
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--quantize-edges") world.quantizeEdges = true;
+    }
+    // Visibility polygon kept up to date incrementally as the player moves;
+    // F5 switches to recomputing it from scratch every frame.
+    KineticVisibility kinetic;
+    bool kineticVisibility = true;
+    // Shortest routes for the Arrow powerup; replanned when the player has
+    // moved a little or the nearest target changes
+    PathGraph paths(&levelArena);
+    std::vector<sf::Vector2f> arrowRoute;
+    PathGraph::Search arrowSearch;
+    sf::Vector2f arrowFrom;
+    int arrowTarget = -1;
+    std::pmr::vector<sf::RectangleShape> walls(&levelArena);
+    std::pmr::vector<sf::ConvexShape> polyShapes(&levelArena);
+    std::pmr::vector<sf::CircleShape> circleShapes(&levelArena);
+    sf::VertexArray gridMesh;
+    // Wall shapes bucketed into chunks by the centre of their bounds (chunk c
+    // owns chunkItems[chunkStart[c] .. chunkStart[c + 1]]); each chunk the
+    // camera sees is one render job
+    const float WALL_CHUNK = 512.f;
+    std::pmr::vector<sf::FloatRect> chunkBounds(&levelArena);
+    std::pmr::vector<std::uint32_t> chunkStart(&levelArena);
+    std::pmr::vector<const sf::Shape*> chunkItems(&levelArena);
+    std::vector<std::uint32_t> visibleChunks;
+
+    // World and light draws are recorded by worker threads, then submitted
+    // sorted by layer, blend mode and texture
+    RenderQueue renderQueue;
+    renderQueue.setBlendMode(RenderQueue::Blend::Erase, ERASE_BLEND);
+    renderQueue.setBlendMode(RenderQueue::Blend::Glow, ADD_GLOW);
+
+    // Gameplay state: everything simStep() touches lives in 'sim'
+    SimLevel simLevel(&levelArena);
+    GameState sim{};
+    std::unique_ptr<RollbackSession> versus;
+    float versusAccum = 0.f;
+    int localPlayer = 0;
+
+    // Rival in versus mode
+    sf::CircleShape rivalCircle(PLAYER_RADIUS);
+    rivalCircle.setOrigin({ PLAYER_RADIUS, PLAYER_RADIUS });
+    rivalCircle.setFillColor(sf::Color(255, 120, 200));
 
     auto setPlayerPos = [&](sf::Vector2f p) {
         if (playerSprite) playerSprite->setPosition(p);
@@ -647,13 +1608,9 @@ int main() {
         return playerSprite ? playerSprite->getPosition() : playerCircle.getPosition();
         };
 
-    auto setTargetPos = [&](sf::Vector2f p) {
-        if (targetSprite) targetSprite->setPosition(p);
-        targetCircle.setPosition(p);
-        };
-    auto getTargetPos = [&]() -> sf::Vector2f {
-        return targetSprite ? targetSprite->getPosition() : targetCircle.getPosition();
-        };
+    // Remaining targets; nearest-target queries run every frame
+    KdTree2 targets(&levelArena);
+    std::size_t targetTotal = 0;
 
     auto resetAnimations = [&]() {
         playerFrame = 0;
@@ -661,26 +1618,90 @@ int main() {
         playerAnimTimer = 0.f;
         targetAnimTimer = 0.f;
 
-        if (playerSprite && !playerFrames.empty()) {
-            sf::Vector2f keep = getPlayerPos();
-            playerSprite->setTexture(playerFrames[playerFrame], true);
-            fitSpriteToDiameter(*playerSprite, playerFrames[playerFrame], PLAYER_RADIUS * 2.f);
-            playerSprite->setPosition(keep);
-        }
-        if (targetSprite && !targetFrames.empty()) {
-            sf::Vector2f keep = getTargetPos();
-            targetSprite->setTexture(targetFrames[targetFrame], true);
-            fitSpriteToDiameter(*targetSprite, targetFrames[targetFrame], TARGET_RADIUS * 2.f);
-            targetSprite->setPosition(keep);
-        }
+        if (playerSprite) bindFrame(*playerSprite, playerFrames[playerFrame], PLAYER_RADIUS * 2.f);
+        if (targetSprite) bindFrame(*targetSprite, targetFrames[targetFrame], TARGET_RADIUS * 2.f);
         };
 
     auto rebuildWallsFromLevel = [&](const LevelDef& L) {
-        walls.clear();
+        // Unload: every arena-backed container lets go of its storage, then
+        // the arena is rewound in one go
+        paths.clear();
+        world.clear();
+        simLevel.clear();
+        targets.clear();
+        floorLayer.clear();
+        dropStorage(walls);
+        dropStorage(polyShapes);
+        dropStorage(circleShapes);
+        dropStorage(chunkBounds);
+        dropStorage(chunkStart);
+        dropStorage(chunkItems);
+        levelArena.release();
+
+        walls.reserve(L.wallRects.size());
+        polyShapes.reserve(L.polygons.size());
+        circleShapes.reserve(L.circles.size());
+
         for (const auto& r : L.wallRects) {
             walls.push_back(makeWall(r.x, r.y, r.w, r.h));
         }
-        wallSegs = buildWallSegments(walls);
+        for (const auto& p : L.polygons) {
+            sf::ConvexShape shape(p.pts.size());
+            for (std::size_t i = 0; i < p.pts.size(); ++i) shape.setPoint(i, p.pts[i]);
+            shape.setFillColor(sf::Color(80, 80, 80));
+            polyShapes.push_back(shape);
+        }
+        for (const auto& c : L.circles) {
+            sf::CircleShape shape(c.r, 40);
+            shape.setOrigin({ c.r, c.r });
+            shape.setPosition(c.c);
+            shape.setFillColor(sf::Color(80, 80, 80));
+            circleShapes.push_back(shape);
+        }
+
+        buildLevelGeometry(L, world);
+        gridMesh = buildGridMesh(world.grid, sf::Color(80, 80, 80));
+
+        // Chunk index over the wall shapes (their addresses are stable: the
+        // lists were reserved up front and do not change until the next load)
+        std::vector<const sf::Shape*> shapes;
+        shapes.reserve(walls.size() + polyShapes.size() + circleShapes.size());
+        for (const auto& w : walls) shapes.push_back(&w);
+        for (const auto& p : polyShapes) shapes.push_back(&p);
+        for (const auto& c : circleShapes) shapes.push_back(&c);
+
+        const int cols = std::max(1, static_cast<int>(std::ceil(L.worldW / WALL_CHUNK)));
+        const int rows = std::max(1, static_cast<int>(std::ceil(L.worldH / WALL_CHUNK)));
+        const std::size_t chunkCount = static_cast<std::size_t>(cols) * rows;
+        std::vector<std::uint32_t> chunkOf(shapes.size());
+        chunkStart.assign(chunkCount + 1, 0);
+        for (std::size_t i = 0; i < shapes.size(); ++i) {
+            sf::FloatRect b = shapes[i]->getGlobalBounds();
+            sf::Vector2f c = b.position + b.size / 2.f;
+            int cx = std::clamp(static_cast<int>(std::floor(c.x / WALL_CHUNK)), 0, cols - 1);
+            int cy = std::clamp(static_cast<int>(std::floor(c.y / WALL_CHUNK)), 0, rows - 1);
+            chunkOf[i] = static_cast<std::uint32_t>(cy * cols + cx);
+            chunkStart[chunkOf[i] + 1]++;
+        }
+        for (std::size_t c = 0; c < chunkCount; ++c) chunkStart[c + 1] += chunkStart[c];
+
+        std::vector<std::uint32_t> fill(chunkStart.begin(), chunkStart.end() - 1);
+        chunkItems.resize(shapes.size());
+        for (std::size_t i = 0; i < shapes.size(); ++i) chunkItems[fill[chunkOf[i]]++] = shapes[i];
+
+        // A chunk's bounds cover its shapes, which may reach past the chunk itself
+        chunkBounds.assign(chunkCount, sf::FloatRect());
+        for (std::size_t c = 0; c < chunkCount; ++c) {
+            if (chunkStart[c] == chunkStart[c + 1]) continue;
+            sf::Vector2f lo(std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
+            sf::Vector2f hi(std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest());
+            for (std::uint32_t k = chunkStart[c]; k < chunkStart[c + 1]; ++k) {
+                sf::FloatRect b = chunkItems[k]->getGlobalBounds();
+                lo = { std::min(lo.x, b.position.x), std::min(lo.y, b.position.y) };
+                hi = { std::max(hi.x, b.position.x + b.size.x), std::max(hi.y, b.position.y + b.size.y) };
+            }
+            chunkBounds[c] = sf::FloatRect(lo, hi - lo);
+        }
         };
 
     auto setTitleForLevel = [&]() {
@@ -688,12 +1709,6 @@ int main() {
         window.setTitle("67 Hunt - " + std::to_string(currentLevel) + ": " + L.name);
         };
 
-    auto resetTempEffects = [&]() {
-        speedBoostLeft = 0.f;
-        arrowLeft = 0.f;
-        fullLightLeft = 0.f;
-        };
-
     auto loadLevel = [&](int levelIndex1Based) {
         currentLevel = std::clamp(levelIndex1Based, 1, LEVEL_COUNT);
         const LevelDef& L = levels[currentLevel - 1];
@@ -702,21 +1717,66 @@ int main() {
         WORLD_H = L.worldH;
 
         rebuildWallsFromLevel(L);
-        setPlayerPos(L.playerSpawn);
-        setTargetPos(L.targetSpawn);
-
-        // copy powerups fresh (so they respawn each restart)
-        powerups = L.powerups;
+        kinetic.reset();
+        paths.build(world, { WORLD_W, WORLD_H }, PLAYER_RADIUS);
+        arrowTarget = -1;
+
+        const float floorTile = static_cast<float>(FLOOR_TILE_PX);
+        floorLayer.reset((int)std::ceil(WORLD_W / floorTile), (int)std::ceil(WORLD_H / floorTile), floorTile);
+        for (int y = 0; y < floorLayer.getRows(); ++y) {
+            for (int x = 0; x < floorLayer.getCols(); ++x) floorLayer.setTile(x, y, floorVariantAt(x, y, FLOOR_VARIANTS));
+        }
 
-        timeLeft = LEVEL_TIME_LIMIT;
-        resetTempEffects();
+        // Fresh state each (re)start, so powerups respawn
+        versus.reset();
+        localPlayer = 0;
+        simLevel.build(L, world, tuning);
+        sim = makeInitialState(simLevel, 1);
+        recording = replay::Replay{};
+        recording.levelName = L.name;
+        recording.level = replay::levelFingerprint(L, tuning);
+        replayAccum = 0.f;
+
+        setPlayerPos(sim.players[0].pos);
+        targets.build(simLevel.targets);
+        targetTotal = simLevel.targets.size();
+        footprintDist = 0.f;
         mode = GameMode::Playing;
 
         resetAnimations();
         setTitleForLevel();
         };
 
+    auto startVersus = [&]() {
+        loadLevel(versusLevel);
+        auto session = std::make_unique<RollbackSession>();
+        unsigned short mine = static_cast<unsigned short>(versusPort + versusPlayer);
+        unsigned short theirs = static_cast<unsigned short>(versusPort + 1 - versusPlayer);
+        if (!session->start(simLevel, versusPlayer, mine, theirs)) return;
+        versus = std::move(session);
+        versusAccum = 0.f;
+        localPlayer = versusPlayer;
+        sim = versus->state();
+        setPlayerPos(sim.players[localPlayer].pos);
+        window.setTitle("67 Hunt - VERSUS (player " + std::to_string(versusPlayer + 1) + ")");
+        };
+
+    // Mirror sim target liveness into the drawable index (targets can come
+    // back when a rollback undoes a pickup).
+    auto syncTargets = [&]() {
+        if (!versus && targets.size() == sim.targetsLeft) return;
+        bool revived = false;
+        for (std::uint32_t id = 0; id < simLevel.targets.size(); ++id) {
+            if (sim.isTargetAlive(id) && !targets.isAlive(id)) revived = true;
+        }
+        if (revived) targets.build(simLevel.targets);
+        for (std::uint32_t id = 0; id < simLevel.targets.size(); ++id) {
+            if (!sim.isTargetAlive(id)) targets.remove(id);
+        }
+        };
+
     auto goToMenu = [&]() {
+        versus.reset();
         mode = GameMode::Menu;
         window.setTitle("67 Hunt");
         window.setView(window.getDefaultView());
@@ -764,6 +1824,12 @@ int main() {
     hintText.setFillColor(sf::Color(220, 220, 220));
     hintText.setPosition({ 20.f, 55.f });
 
+    // F3 debug overlay (streaming / floor cache counters)
+    sf::Text debugText(font, "", 16);
+    debugText.setFillColor(sf::Color(170, 230, 170));
+    debugText.setPosition({ 20.f, static_cast<float>(H) - 260.f });
+    bool showDebug = false;
+
     setCentered(titleText, W / 2.f, H / 2.f - 210.f);
 
     // Menu selection
@@ -783,20 +1849,129 @@ int main() {
     rebuildMenuText();
 
     // Key edge states
-    bool wasW = false, wasS = false, wasEnter = false, wasM = false, wasR = false, wasN = false;
+    bool wasW = false, wasS = false, wasEnter = false, wasM = false, wasR = false, wasN = false, wasF3 = false, wasF4 = false, wasF5 = false;
+
+    // ---------------- Glyph prewarm (loading screen) ----------------
+    // Every character size the UI uses; keep in sync with the texts above.
+    const unsigned UI_FONT_SIZES[] = { 78, 52, 28, 24, 22, 20, 18, 16 };
+    if (font.getInfo().family != "") {
+        std::string charset;
+        for (char ch = 32; ch < 127; ++ch) charset += ch;
+
+        sf::Text loadingText(font, "Loading...", 28);
+        loadingText.setFillColor(sf::Color(200, 200, 200));
+        setCentered(loadingText, W / 2.f, H / 2.f - 30.f);
+
+        const float barW = 360.f;
+        sf::RectangleShape barBack({ barW, 10.f });
+        barBack.setPosition({ W / 2.f - barW / 2.f, H / 2.f + 10.f });
+        barBack.setFillColor(sf::Color(40, 40, 48));
+        sf::RectangleShape barFill = barBack;
+        barFill.setFillColor(sf::Color(255, 190, 140));
+
+        const std::size_t sizeCount = std::size(UI_FONT_SIZES);
+        for (std::size_t i = 0; i < sizeCount && window.isOpen(); ++i) {
+            while (auto ev = window.pollEvent()) {
+                if (ev->is<sf::Event::Closed>()) window.close();
+            }
+            prewarmGlyphs(font, UI_FONT_SIZES[i], charset);
+
+            barFill.setSize({ barW * static_cast<float>(i + 1) / sizeCount, 10.f });
+            window.clear(sf::Color(10, 10, 14));
+            window.draw(loadingText);
+            window.draw(barBack);
+            window.draw(barFill);
+            window.display();
+        }
+
+        std::cout << "Glyph pages after prewarm:\n";
+        for (unsigned size : UI_FONT_SIZES) {
+            sf::Vector2u page = font.getTexture(size).getSize();
+            std::cout << "  size " << size << ": " << page.x << "x" << page.y
+                << " (" << (page.x * page.y * 4u) / 1024u << " KiB)\n";
+        }
+    }
+
+    // Flythrough state: the player is moved a fixed distance per frame so
+    // every run renders the same frames whatever the frame rate.
+    const float FLY_STEP = 10.f;
+    const int FLY_WARMUP_FRAMES = 30;          // texture uploads, first-use costs
+    const std::size_t FLY_MAX_FRAMES = 20000;  // per level, for huge imported maps
+    std::vector<sf::Vector2f> flyPath;
+    std::size_t flyWaypoint = 0;
+    int flyFrame = 0;
+    std::vector<float> flyFrameMs;
+    std::vector<FrameTimeStats> flyResults;
+
+    auto startFlythroughLevel = [&](int levelIndex1Based) {
+        loadLevel(levelIndex1Based);
+        flyPath = buildFlythroughPath(levels[currentLevel - 1], world, paths, H * 0.5f, PLAYER_RADIUS);
+        flyWaypoint = 0;
+        flyFrame = 0;
+        flyFrameMs.clear();
+        flyFrameMs.reserve(4096);
+        };
 
-    // Start in menu
-    goToMenu();
+    // Start in menu (or straight into the race / flythrough)
+    if (flythrough) startFlythroughLevel(1);
+    else if (versusPlayer >= 0) startVersus();
+    else goToMenu();
+
+    // Frame-time window for the metrics endpoint (about 2 s at 120 FPS)
+    const std::size_t METRICS_WINDOW = 240;
+    const std::uint64_t METRICS_PUBLISH_EVERY = 30;
+    std::vector<float> frameMsWindow(METRICS_WINDOW, 0.f);
+    std::uint64_t frameCounter = 0;
+    float visibilityUs = 0.f;
+    std::uint32_t visibilityVerts = 0;
+    PerfSample visibilityPerf;
 
     // ---------------- Main loop ----------------
     while (window.isOpen()) {
         float dt = clock.restart().asSeconds();
+        textures.update();
+
+        // ---------------- Metrics ----------------
+        frameMsWindow[frameCounter % METRICS_WINDOW] = dt * 1000.f;
+        frameCounter++;
+        if (metrics.isRunning() && frameCounter % METRICS_PUBLISH_EVERY == 0) {
+            std::size_t n = std::min<std::size_t>(frameCounter, METRICS_WINDOW);
+            std::vector<float> sorted(frameMsWindow.begin(), frameMsWindow.begin() + n);
+            std::sort(sorted.begin(), sorted.end());
+            float sum = 0.f;
+            for (float ms : sorted) sum += ms;
+
+            MetricsSnapshot m;
+            m.frame = frameCounter;
+            m.fps = sum > 0.f ? 1000.f * n / sum : 0.f;
+            m.frameMsP50 = sorted[n / 2];
+            m.frameMsP99 = sorted[std::min(n - 1, n * 99 / 100)];
+            m.frameMsMax = sorted.back();
+            m.visibilityUs = visibilityUs;
+            m.visibilityVerts = visibilityVerts;
+            m.visibilityPerf = visibilityPerf.valid;
+            m.visibilityCycles = visibilityPerf.cycles;
+            m.visibilityInstructions = visibilityPerf.instructions;
+            m.visibilityCacheMisses = visibilityPerf.cacheMisses;
+            m.visibilityBranchMisses = visibilityPerf.branchMisses;
+            m.level = mode == GameMode::Menu ? 0 : currentLevel;
+            m.mode = static_cast<std::int32_t>(mode);
+            m.targetsLeft = static_cast<std::uint32_t>(targets.size());
+            m.timeLeft = sim.timeLeft;
+            m.textureBytes = textures.getStats().residentBytes;
+            m.textureBudget = textures.getStats().budgetBytes;
+            m.floorBytes = floorLayer.residentBytes();
+            metrics.publish(m);
+        }
 
         while (auto ev = window.pollEvent()) {
             if (ev->is<sf::Event::Closed>()) window.close();
         }
 
         if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::Escape)) window.close();
+        if (pressedOnce(sf::Keyboard::Key::F3, wasF3)) showDebug = !showDebug;
+        if (pressedOnce(sf::Keyboard::Key::F4, wasF4)) singlePassDarkness = !singlePassDarkness;
+        if (pressedOnce(sf::Keyboard::Key::F5, wasF5)) kineticVisibility = !kineticVisibility;
 
         // ---------------- MENU ----------------
         if (mode == GameMode::Menu) {
@@ -829,10 +2004,11 @@ int main() {
                 goToMenu();
                 continue;
             }
-            if (pressedOnce(sf::Keyboard::Key::R, wasR)) {
+            // Restart / next would desync a versus match; only M leaves it
+            if (pressedOnce(sf::Keyboard::Key::R, wasR) && !versus) {
                 loadLevel(currentLevel);
             }
-            if (mode == GameMode::Win && pressedOnce(sf::Keyboard::Key::N, wasN)) {
+            if (mode == GameMode::Win && pressedOnce(sf::Keyboard::Key::N, wasN) && !versus) {
                 int next = currentLevel + 1;
                 if (next > LEVEL_COUNT) { goToMenu(); continue; }
                 loadLevel(next);
@@ -844,13 +2020,6 @@ int main() {
             pressedOnce(sf::Keyboard::Key::N, wasN);
         }
 
-        // ---------------- Temporary effect timers ----------------
-        if (mode == GameMode::Playing) {
-            speedBoostLeft = std::max(0.f, speedBoostLeft - dt);
-            arrowLeft = std::max(0.f, arrowLeft - dt);
-            fullLightLeft = std::max(0.f, fullLightLeft - dt);
-        }
-
         // ---------------- Animate sprites ----------------
         if (mode == GameMode::Playing) {
             if (playerSprite) {
@@ -858,11 +2027,6 @@ int main() {
                 while (playerAnimTimer >= frameTime) {
                     playerAnimTimer -= frameTime;
                     playerFrame = (playerFrame + 1) % FRAME_COUNT;
-
-                    sf::Vector2f keepPos = getPlayerPos();
-                    playerSprite->setTexture(playerFrames[playerFrame], true);
-                    fitSpriteToDiameter(*playerSprite, playerFrames[playerFrame], PLAYER_RADIUS * 2.f);
-                    playerSprite->setPosition(keepPos);
                 }
             }
             if (targetSprite) {
@@ -870,73 +2034,116 @@ int main() {
                 while (targetAnimTimer >= frameTime) {
                     targetAnimTimer -= frameTime;
                     targetFrame = (targetFrame + 1) % FRAME_COUNT;
+                }
+            }
+        }
 
-                    sf::Vector2f keepPos = getTargetPos();
-                    targetSprite->setTexture(targetFrames[targetFrame], true);
-                    fitSpriteToDiameter(*targetSprite, targetFrames[targetFrame], TARGET_RADIUS * 2.f);
-                    targetSprite->setPosition(keepPos);
+        // Re-bind every frame: the cache may have evicted or reloaded a frame
+        // since last time, and get() is what keeps it warm in the LRU.
+        if (playerSprite) bindFrame(*playerSprite, playerFrames[playerFrame], PLAYER_RADIUS * 2.f);
+        if (targetSprite) bindFrame(*targetSprite, targetFrames[targetFrame], TARGET_RADIUS * 2.f);
+
+        // ---------------- Flythrough benchmark ----------------
+        if (flythrough) {
+            // dt is the whole previous frame, display included
+            if (flyFrame++ > FLY_WARMUP_FRAMES) flyFrameMs.push_back(dt * 1000.f);
+
+            float step = FLY_STEP;
+            sf::Vector2f pos = sim.players[0].pos;
+            while (step > 0.f && flyWaypoint < flyPath.size()) {
+                sf::Vector2f d = flyPath[flyWaypoint] - pos;
+                float len = std::sqrt(d.x * d.x + d.y * d.y);
+                if (len <= step) { pos = flyPath[flyWaypoint++]; step -= len; }
+                else { pos += d * (step / len); step = 0.f; }
+            }
+            sim.players[0].pos = pos;
+            sim.players[0].fullLightLeft = 0.f;
+            setPlayerPos(pos);
+
+            if (flyWaypoint >= flyPath.size() || flyFrameMs.size() >= FLY_MAX_FRAMES) {
+                flyResults.push_back(summarizeFrameTimes(std::to_string(currentLevel) + ": " + levels[currentLevel - 1].name, flyFrameMs));
+                if (currentLevel < LEVEL_COUNT) {
+                    startFlythroughLevel(currentLevel + 1);
+                }
+                else {
+                    std::cout << "\nFlythrough (" << W << "x" << H << ", uncapped, FullLight off, "
+                        << (singlePassDarkness ? "single-pass" : "render-texture") << " darkness):\n";
+                    printFrameTimeTable(flyResults);
+                    window.close();
+                    continue;
                 }
             }
         }
 
         // ---------------- Update gameplay ----------------
-        if (mode == GameMode::Playing) {
-            timeLeft -= dt;
-            if (timeLeft <= 0.f) {
-                timeLeft = 0.f;
-                mode = GameMode::Lose;
-                window.setTitle("67 Hunt - TIME'S UP (M = menu)");
+        // A finished race keeps answering until the peer has every input it needs
+        if (versus && mode != GameMode::Playing) versus->poll();
+
+        if (mode == GameMode::Playing && !flythrough) {
+            std::uint8_t input = readMovementInput();
+            sf::Vector2f oldPos = sim.players[localPlayer].pos;
+            std::uint64_t oldPowerups = sim.powerupActive;
+
+            if (versus) {
+                // Fixed ticks; a few per frame at most so a stall can't snowball
+                versusAccum = std::min(versusAccum + dt, 4.f * SIM_TICK_DT);
+                while (versusAccum >= SIM_TICK_DT && !versus->finished()) {
+                    if (!versus->advance(input)) { versusAccum = 0.f; break; }
+                    versusAccum -= SIM_TICK_DT;
+                }
+                // Predicted while playing; the result comes from confirmed inputs only
+                sim = versus->finished() ? versus->confirmedState() : versus->state();
             }
-
-            float speed = BASE_SPEED;
-            if (speedBoostLeft > 0.f) speed *= SPEED_MULT;
-
-            sf::Vector2f dir(0.f, 0.f);
-            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::W)) dir.y -= 1.f;
-            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::S)) dir.y += 1.f;
-            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::A)) dir.x -= 1.f;
-            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::D)) dir.x += 1.f;
-            dir = normalize(dir);
-
-            sf::Vector2f oldPos = getPlayerPos();
-            setPlayerPos(oldPos + dir * speed * dt);
-
-            for (const auto& w : walls) {
-                if (circleIntersectsRect(getPlayerPos(), PLAYER_RADIUS, w.getGlobalBounds())) {
-                    setPlayerPos(oldPos);
-                    break;
+            else if (!replayDir.empty()) {
+                // Same fixed ticks as versus, so the log replays exactly
+                replayAccum = std::min(replayAccum + dt, 4.f * SIM_TICK_DT);
+                while (replayAccum >= SIM_TICK_DT && sim.status == SimStatus::Playing) {
+                    recording.record(&input);
+                    simStep(simLevel, sim, &input, SIM_TICK_DT);
+                    replayAccum -= SIM_TICK_DT;
+                }
+                if (sim.status == SimStatus::Cleared) {
+                    recording.finalHash = replay::hashState(sim);
+                    std::string path = replayDir + "/level" + std::to_string(currentLevel) + "-" + std::to_string(sim.tick) + ".mgrp";
+                    if (replay::saveReplay(path, recording)) std::cout << "Replay saved: " << path << "\n";
                 }
             }
+            else {
+                simStep(simLevel, sim, &input, dt);
+            }
 
-            // --- Powerup pickup check ---
-            for (auto& p : powerups) {
-                if (!p.active) continue;
-                if (circleIntersectsCircle(getPlayerPos(), PLAYER_RADIUS, p.pos, PWR_RADIUS)) {
-                    p.active = false;
+            const PlayerState& me = sim.players[localPlayer];
+            setPlayerPos(me.pos);
+            syncTargets();
+
+            // Footprints, alternating feet along the direction of travel
+            sf::Vector2f dir = inputDirection(input);
+            sf::Vector2f moved = me.pos - oldPos;
+            footprintDist += std::sqrt(moved.x * moved.x + moved.y * moved.y);
+            if (footprintDist >= FOOTPRINT_STRIDE) {
+                footprintDist = 0.f;
+                footprintLeft = !footprintLeft;
+                sf::Vector2f side = { -dir.y * 7.f, dir.x * 7.f };
+                if (footprintLeft) side = -side;
+                floorLayer.addDecal({ DecalType::Footprint, me.pos + side, FOOTPRINT_SIZE, std::atan2(dir.y, dir.x) });
+            }
 
-                    if (p.type == PowerType::AddTime) {
-                        timeLeft += TIME_ADD_SECONDS;
-                        // optional clamp so it doesn't go crazy:
-                        timeLeft = std::min(timeLeft, LEVEL_TIME_LIMIT + 20.f);
-                    }
-                    else if (p.type == PowerType::Speed) {
-                        speedBoostLeft = std::max(speedBoostLeft, SPEED_DURATION);
-                    }
-                    else if (p.type == PowerType::Arrow) {
-                        arrowLeft = std::max(arrowLeft, ARROW_DURATION);
-                    }
-                    else if (p.type == PowerType::FullLight) {
-                        fullLightLeft = std::max(fullLightLeft, FULLLIGHT_DURATION);
-                    }
-                }
+            // Scorch wherever a powerup was just taken
+            std::uint64_t taken = oldPowerups & ~sim.powerupActive;
+            for (std::size_t i = 0; i < simLevel.powerups.size(); ++i) {
+                if ((taken >> i) & 1u) floorLayer.addDecal({ DecalType::Scorch, simLevel.powerups[i].pos, SCORCH_SIZE });
             }
 
-            // Win condition
-            if (circleIntersectsCircle(getPlayerPos(), PLAYER_RADIUS, getTargetPos(), TARGET_RADIUS)) {
-                mode = GameMode::Win;
-                window.setTitle("67 Hunt - LEVEL CLEARED (N next / M menu)");
+            if (versus ? versus->finished() : sim.status != SimStatus::Playing) {
+                bool won = sim.status == SimStatus::Cleared;
+                if (versus) won = me.collected >= sim.players[1 - localPlayer].collected;
+                mode = won ? GameMode::Win : GameMode::Lose;
+                if (versus) window.setTitle(won ? "67 Hunt - RACE WON (M = menu)" : "67 Hunt - RACE LOST (M = menu)");
+                else if (won) window.setTitle("67 Hunt - LEVEL CLEARED (N next / M menu)");
+                else window.setTitle("67 Hunt - TIME'S UP (M = menu)");
             }
         }
+        const PlayerState& me = sim.players[localPlayer];
 
         // ---------------- Camera follow ----------------
         {
@@ -946,27 +2153,35 @@ int main() {
         }
 
         // ---------------- UI update ----------------
-        timerText.setString("Time: " + std::to_string((int)std::ceil(timeLeft)));
+        timerText.setString("Time: " + std::to_string((int)std::ceil(sim.timeLeft)));
         {
             const LevelDef& L = levels[currentLevel - 1];
-            levelText.setString("Level " + std::to_string(currentLevel) + ": " + L.name);
+            std::string s = "Level " + std::to_string(currentLevel) + ": " + L.name;
+            if (versus) {
+                s += "   You " + std::to_string(me.collected) + " - " + std::to_string(sim.players[1 - localPlayer].collected) + " Rival";
+                if (!versus->peerSeen()) s += "   (waiting for player " + std::to_string(2 - localPlayer) + ")";
+            }
+            else if (targetTotal > 1) {
+                s += "   Sevens: " + std::to_string(targetTotal - targets.size()) + "/" + std::to_string(targetTotal);
+            }
+            levelText.setString(s);
         }
 
         // effects text
         {
             std::string e;
-            if (speedBoostLeft > 0.f) e += "Speed: " + std::to_string((int)std::ceil(speedBoostLeft)) + "s  ";
-            if (arrowLeft > 0.f)      e += "Arrow: " + std::to_string((int)std::ceil(arrowLeft)) + "s  ";
-            if (fullLightLeft > 0.f)  e += "Light: " + std::to_string((int)std::ceil(fullLightLeft)) + "s  ";
+            if (me.speedBoostLeft > 0.f) e += "Speed: " + std::to_string((int)std::ceil(me.speedBoostLeft)) + "s  ";
+            if (me.arrowLeft > 0.f)      e += "Arrow: " + std::to_string((int)std::ceil(me.arrowLeft)) + "s  ";
+            if (me.fullLightLeft > 0.f)  e += "Light: " + std::to_string((int)std::ceil(me.fullLightLeft)) + "s  ";
             effectsText.setString(e);
         }
 
         if (mode == GameMode::Win) {
-            centerText.setString("LEVEL COMPLETE!");
+            centerText.setString(versus ? "YOU WIN THE RACE!" : "LEVEL COMPLETE!");
             setCentered(centerText, W / 2.f, H / 2.f);
         }
         else if (mode == GameMode::Lose) {
-            centerText.setString("TIME'S UP!");
+            centerText.setString(versus ? "RIVAL WINS!" : "TIME'S UP!");
             setCentered(centerText, W / 2.f, H / 2.f);
         }
 
@@ -974,64 +2189,138 @@ int main() {
         window.clear({ 15, 15, 20 });
         window.setView(camera);
 
-        // powerups (world space)
-        if (font.getInfo().family != "") {
-            for (const auto& p : powerups) {
-                if (!p.active) continue;
-
-                sf::CircleShape c(PWR_RADIUS);
-                c.setOrigin({ PWR_RADIUS, PWR_RADIUS });
-                c.setPosition(p.pos);
-                c.setFillColor(powerColor(p.type));
-                window.draw(c);
+        floorLayer.draw(window, camera);
+
+        // Record the world in parallel: one job per wall chunk in view, then
+        // the grid mesh, powerups, targets and players. Jobs only read the
+        // level and sim state, and every shape or sprite they transform
+        // belongs to exactly one job (targets use a copy of the sprite).
+        renderQueue.clear();
+        const sf::FloatRect viewRect(camera.getCenter() - camera.getSize() / 2.f, camera.getSize());
+        visibleChunks.clear();
+        for (std::size_t c = 0; c < chunkBounds.size(); ++c) {
+            if (chunkStart[c] != chunkStart[c + 1] && chunkBounds[c].findIntersection(viewRect)) {
+                visibleChunks.push_back(static_cast<std::uint32_t>(c));
+            }
+        }
+        const std::size_t wallJobs = visibleChunks.size();
+        renderQueue.record(wallJobs + 4, [&](std::size_t job, RenderQueue::Recorder& rec) {
+            if (job < wallJobs) {
+                std::uint32_t c = visibleChunks[job];
+                for (std::uint32_t k = chunkStart[c]; k < chunkStart[c + 1]; ++k) rec.shape(LAYER_WALLS, *chunkItems[k]);
+                return;
+            }
+            switch (job - wallJobs) {
+            case 0:
+                rec.vertexArray(LAYER_WALLS, RenderQueue::Blend::Alpha, gridMesh);
+                break;
+            case 1:
+                // powerups (letters are text, recorded on this thread below)
+                for (std::size_t i = 0; i < simLevel.powerups.size(); ++i) {
+                    if (!sim.isPowerupActive(i)) continue;
+                    const PowerUp& p = simLevel.powerups[i];
+                    sf::CircleShape c(PWR_RADIUS);
+                    c.setOrigin({ PWR_RADIUS, PWR_RADIUS });
+                    c.setPosition(p.pos);
+                    c.setFillColor(powerColor(p.type));
+                    rec.shape(LAYER_POWERUPS, c);
+                }
+                break;
+            case 2: {
+                // targets (only the ones around the camera)
+                sf::Vector2f half = camera.getSize() / 2.f;
+                float reach = std::sqrt(half.x * half.x + half.y * half.y) + TARGET_RADIUS;
+                if (targetSprite) {
+                    sf::Sprite s = *targetSprite;
+                    targets.forEachWithin(camera.getCenter(), reach, [&](std::uint32_t id) {
+                        s.setPosition(targets.point(id));
+                        rec.sprite(LAYER_TARGETS, s);
+                        });
+                }
+                else {
+                    sf::CircleShape s = targetCircle;
+                    targets.forEachWithin(camera.getCenter(), reach, [&](std::uint32_t id) {
+                        s.setPosition(targets.point(id));
+                        rec.shape(LAYER_TARGETS, s);
+                        });
+                }
+                break;
+            }
+            case 3:
+                // rival (versus), tinted copy of the player
+                if (versus) {
+                    sf::Vector2f rivalPos = sim.players[1 - localPlayer].pos;
+                    if (playerSprite) {
+                        sf::Sprite rival = *playerSprite;
+                        rival.setPosition(rivalPos);
+                        rival.setColor(sf::Color(255, 140, 210));
+                        rec.sprite(LAYER_ENTITIES, rival);
+                    }
+                    else {
+                        sf::CircleShape rival = rivalCircle;
+                        rival.setPosition(rivalPos);
+                        rec.shape(LAYER_ENTITIES, rival);
+                    }
+                }
+                // player
+                if (playerSprite) rec.sprite(LAYER_ENTITIES, *playerSprite);
+                else rec.shape(LAYER_ENTITIES, playerCircle);
+                break;
+            }
+            });
 
-                // letter
+        // powerup letters: glyphs get loaded on first use, which needs GL
+        if (font.getInfo().family != "") {
+            RenderQueue::Recorder& labels = renderQueue.direct();
+            for (std::size_t i = 0; i < simLevel.powerups.size(); ++i) {
+                if (!sim.isPowerupActive(i)) continue;
+                const PowerUp& p = simLevel.powerups[i];
                 sf::Text t(font, std::string(1, powerLetter(p.type)), 16);
                 t.setFillColor(sf::Color::Black);
                 setCentered(t, p.pos.x, p.pos.y - 1.f);
-                window.draw(t);
+                labels.text(LAYER_POWERUP_LABELS, t);
             }
         }
-        else {
-            // if font failed, still draw circles
-            for (const auto& p : powerups) {
-                if (!p.active) continue;
-                sf::CircleShape c(PWR_RADIUS);
-                c.setOrigin({ PWR_RADIUS, PWR_RADIUS });
-                c.setPosition(p.pos);
-                c.setFillColor(powerColor(p.type));
-                window.draw(c);
-            }
-        }
-
-        // target
-        if (targetSprite) window.draw(*targetSprite);
-        else window.draw(targetCircle);
 
-        // walls
-        for (auto& w : walls) window.draw(w);
-
-        // player
-        if (playerSprite) window.draw(*playerSprite);
-        else window.draw(playerCircle);
+        renderQueue.submit(window, LAYER_POWERUPS, LAYER_ENTITIES);
 
         // ---------------- Overlay + UI (screen space) ----------------
         window.setView(window.getDefaultView());
 
         // ARROW power: draw arrow on top of world, below UI (so it's visible)
-        if (arrowLeft > 0.f && mode == GameMode::Playing) {
-            sf::Vector2f from = (sf::Vector2f)window.mapCoordsToPixel(getPlayerPos(), camera);
-            sf::Vector2f to = (sf::Vector2f)window.mapCoordsToPixel(getTargetPos(), camera);
+        int nearestTarget = targets.nearest(getPlayerPos());
+        if (me.arrowLeft > 0.f && mode == GameMode::Playing && nearestTarget >= 0) {
+            // Points at the next bend of the shortest route, not through walls
+            sf::Vector2f p = getPlayerPos();
+            sf::Vector2f moved = p - arrowFrom;
+            if (nearestTarget != arrowTarget || moved.x * moved.x + moved.y * moved.y > 64.f) {
+                paths.findPath(p, targets.point(nearestTarget), arrowRoute, arrowSearch);
+                arrowFrom = p;
+                arrowTarget = nearestTarget;
+            }
+            std::size_t step = 0;
+            while (step + 1 < arrowRoute.size()) {
+                sf::Vector2f d = arrowRoute[step] - p;
+                if (d.x * d.x + d.y * d.y > 256.f) break;
+                step++;
+            }
+            sf::Vector2f from = (sf::Vector2f)window.mapCoordsToPixel(p, camera);
+            sf::Vector2f to = (sf::Vector2f)window.mapCoordsToPixel(arrowRoute[step], camera);
             drawArrowToTarget(window, from, to);
         }
 
         // darkness overlay (unless FullLight is active)
-        if (!(fullLightLeft > 0.f && mode == GameMode::Playing)) {
-            darknessRT.clear(sf::Color(0, 0, 0, 0));
-            darknessRT.draw(darknessRect);
-
+        if (!(me.fullLightLeft > 0.f && mode == GameMode::Playing)) {
             sf::Vector2f originWorld = getPlayerPos();
-            std::vector<sf::Vector2f> polyWorld = computeVisibilityPolygon(originWorld, wallSegs, LIGHT_RANGE);
+            std::vector<sf::Vector2f> polyWorld;
+            {
+                PerfZone zone(perfZoneGroup, visibilityPerf);
+                auto visStart = std::chrono::steady_clock::now();
+                if (kineticVisibility) polyWorld = kinetic.update(world, originWorld, LIGHT_RANGE);
+                else polyWorld = computeVisibilityPolygon(originWorld, world, LIGHT_RANGE);
+                visibilityUs = std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - visStart).count();
+            }
+            visibilityVerts = static_cast<std::uint32_t>(polyWorld.size());
 
             sf::Vector2i originPix = window.mapCoordsToPixel(originWorld, camera);
             sf::Vector2f originScreen((float)originPix.x, (float)originPix.y);
@@ -1043,22 +2332,34 @@ int main() {
                 polyScreen.push_back({ (float)pix.x, (float)pix.y });
             }
 
-            sf::VertexArray glowFan;
-            if (polyScreen.size() >= 3) {
-                sf::VertexArray eraseFan = buildSoftFan_Screen(
-                    originScreen, polyScreen, LIGHT_RANGE,
-                    sf::Color(255, 255, 255, 255)
-                );
-                darknessRT.draw(eraseFan, ERASE_BLEND);
-
-                sf::Color glowColor = WARM_TINT;
-                glowColor.a = static_cast<std::uint8_t>(std::clamp(glowStrength, 0.f, 255.f));
-                glowFan = buildSoftFan_Screen(originScreen, polyScreen, LIGHT_RANGE, glowColor);
+            // Darkness (or the erase fan) and glow meshes are built side by side
+            renderQueue.record(2, [&](std::size_t job, RenderQueue::Recorder& rec) {
+                if (job == 0) {
+                    if (singlePassDarkness) {
+                        rec.vertexArray(LAYER_LIGHT, RenderQueue::Blend::Alpha,
+                            buildDarknessMesh_Screen(originScreen, polyScreen, LIGHT_RANGE, DARK_ALPHA, { (float)W, (float)H }));
+                    }
+                    else if (polyScreen.size() >= 3) {
+                        rec.vertexArray(LAYER_ERASE, RenderQueue::Blend::Erase,
+                            buildSoftFan_Screen(originScreen, polyScreen, LIGHT_RANGE, sf::Color(255, 255, 255, 255)));
+                    }
+                }
+                else if (polyScreen.size() >= 3) {
+                    sf::Color glowColor = WARM_TINT;
+                    glowColor.a = static_cast<std::uint8_t>(std::clamp(glowStrength, 0.f, 255.f));
+                    rec.vertexArray(LAYER_LIGHT, RenderQueue::Blend::Glow,
+                        buildSoftFan_Screen(originScreen, polyScreen, LIGHT_RANGE, glowColor));
+                }
+                });
+
+            if (!singlePassDarkness) {
+                darknessRT.clear(sf::Color(0, 0, 0, 0));
+                darknessRT.draw(darknessRect);
+                renderQueue.submit(darknessRT, LAYER_ERASE, LAYER_ERASE);
+                darknessRT.display();
+                window.draw(sf::Sprite(darknessRT.getTexture()));
             }
-
-            darknessRT.display();
-            window.draw(sf::Sprite(darknessRT.getTexture()));
-            if (polyScreen.size() >= 3) window.draw(glowFan, ADD_GLOW);
+            renderQueue.submit(window, LAYER_LIGHT, LAYER_LIGHT);
         }
 
         // UI
@@ -1071,6 +2372,45 @@ int main() {
             window.draw(hintText);
         }
 
+        if (showDebug) {
+            const TextureManager::Stats& ts = textures.getStats();
+            const FloorLayer::Stats& fs = floorLayer.getStats();
+            std::ostringstream dbg;
+            dbg << "Textures: " << ts.residentBytes / 1024u << " / " << ts.budgetBytes / 1024u << " KiB"
+                << "  (" << ts.residentCount << " resident, " << ts.pendingLoads << " loading)\n"
+                << "  hits " << ts.hits << "  misses " << ts.misses
+                << "  evictions " << ts.evictions << "  failed " << ts.failures << "\n"
+                << "Floor: " << fs.chunksDrawn << " drawn, " << fs.chunksRebuilt << " rebuilt, "
+                << fs.chunksResident << " resident\n"
+                << "Decals: " << fs.decalsStamped << " stamped in " << fs.decalBatches << " batches\n"
+                << "Edges: " << world.edgeCount() << " (" << world.edgeBytes() / 1024u << " KiB, "
+                << (world.edgesQuantized() ? "16-bit" : "float") << ")\n"
+                << "Level arena: " << levelArena.used() / 1024u << " KiB in " << levelArena.count() << " allocations"
+                << (levelArena.hugePages() ? ", huge pages" : "") << (levelArena.used() > levelArena.capacity() ? ", spilled" : "") << "\n"
+                << "Darkness: " << (singlePassDarkness ? "single-pass mesh" : "render texture") << " (F4)";
+            dbg << "\nVisibility: " << static_cast<int>(visibilityUs) << " us, " << visibilityVerts << " verts, "
+                << (kineticVisibility ? "kinetic" : "full") << " (F5)";
+            if (visibilityPerf.valid) {
+                dbg << ", " << visibilityPerf.cycles / 1000u << "k cyc, IPC " << std::round(visibilityPerf.ipc() * 100.0) / 100.0
+                    << ", " << visibilityPerf.cacheMisses << " cache / " << visibilityPerf.branchMisses << " branch misses";
+            }
+            if (kineticVisibility) {
+                const KineticVisibility::Stats& ks = kinetic.stats();
+                dbg << "\nKinetic: " << ks.checked << " checked, " << ks.swaps << " events, " << ks.retraced << " / " << ks.rays << " rays traced"
+                    << (ks.rebuilt ? " (rebuilt)" : "") << ", " << ks.rebuilds << " rebuilds in " << ks.frames << " frames";
+            }
+            const RenderQueue::Stats& rq = renderQueue.stats();
+            dbg << "\nRender: " << rq.jobs << " jobs on " << rq.threads << " threads, "
+                << rq.commands << " commands -> " << rq.batches << " draws, " << rq.vertices << " verts";
+            if (versus) {
+                const RollbackSession::Stats& rs = versus->getStats();
+                dbg << "\nRollback: tick " << sim.tick << ", " << rs.rollbacks << " rollbacks (max " << rs.maxResimTicks
+                    << " ticks, " << rs.maxResimUs << " us), " << rs.stalls << " stalls";
+            }
+            debugText.setString(dbg.str());
+            window.draw(debugText);
+        }
+
         window.display();
     }
 
@@ -0,0 +1,255 @@
+// OccupancyGrid.h
+// Bit-packed solid/empty tile grid for tile-painted levels.
+//
+// One bit per cell, each row padded to whole 64-bit words (plus one spare bit
+// so column boundaries can be diffed in place). Overlap queries test a whole
+// row span per word with masks, and wall edges for visibility come out of a
+// marching-squares pass that is merged into maximal straight runs.
+
+#pragma once
+
+#include "Geometry.h"
+#include <bit>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+struct OccupancyGrid {
+    int cols = 0;
+    int rows = 0;
+    int wordsPerRow = 0;
+    float cellSize = 0.f;
+    sf::Vector2f origin;            // world position of cell (0,0)'s top-left corner
+    std::pmr::vector<std::uint64_t> bits;
+
+    OccupancyGrid() = default;
+    explicit OccupancyGrid(std::pmr::memory_resource* mem) : bits(mem) {}
+
+    // Back to no grid, handing the bits' storage back to their resource.
+    void clear() {
+        cols = rows = wordsPerRow = 0;
+        cellSize = 0.f;
+        origin = {};
+        std::pmr::vector<std::uint64_t>(bits.get_allocator()).swap(bits);
+    }
+
+    void reset(int c, int r, float cell, sf::Vector2f org = { 0.f, 0.f }) {
+        cols = std::max(0, c);
+        rows = std::max(0, r);
+        cellSize = cell;
+        origin = org;
+        wordsPerRow = (cols >> 6) + 1;
+        bits.assign(static_cast<std::size_t>(wordsPerRow) * rows, 0);
+    }
+
+    bool empty() const { return cols == 0 || rows == 0; }
+
+    const std::uint64_t* row(int y) const { return bits.data() + static_cast<std::size_t>(y) * wordsPerRow; }
+    std::uint64_t* row(int y) { return bits.data() + static_cast<std::size_t>(y) * wordsPerRow; }
+
+    // Out-of-range cells read as empty.
+    bool get(int cx, int cy) const {
+        if (cx < 0 || cy < 0 || cx >= cols || cy >= rows) return false;
+        return (row(cy)[cx >> 6] >> (cx & 63)) & 1u;
+    }
+
+    void set(int cx, int cy, bool solid) {
+        if (cx < 0 || cy < 0 || cx >= cols || cy >= rows) return;
+        std::uint64_t m = std::uint64_t(1) << (cx & 63);
+        if (solid) row(cy)[cx >> 6] |= m;
+        else row(cy)[cx >> 6] &= ~m;
+    }
+
+    std::size_t solidCount() const {
+        std::size_t n = 0;
+        for (std::uint64_t w : bits) n += static_cast<std::size_t>(std::popcount(w));
+        return n;
+    }
+
+    std::size_t memoryBytes() const { return bits.size() * sizeof(std::uint64_t); }
+
+    // Any solid cell in columns [x0, x1] of row y? Tests up to 64 cells per word.
+    bool rowSpanAny(int y, int x0, int x1) const {
+        if (y < 0 || y >= rows) return false;
+        x0 = std::max(x0, 0);
+        x1 = std::min(x1, cols - 1);
+        if (x0 > x1) return false;
+
+        const std::uint64_t* r = row(y);
+        int w0 = x0 >> 6;
+        int w1 = x1 >> 6;
+        std::uint64_t firstMask = ~std::uint64_t(0) << (x0 & 63);
+        std::uint64_t lastMask = ~std::uint64_t(0) >> (63 - (x1 & 63));
+
+        if (w0 == w1) return (r[w0] & firstMask & lastMask) != 0;
+        if (r[w0] & firstMask) return true;
+        for (int w = w0 + 1; w < w1; ++w) if (r[w]) return true;
+        return (r[w1] & lastMask) != 0;
+    }
+
+    // Cells whose closed square overlaps the open interval (lo, hi) along one axis.
+    void cellRange(float lo, float hi, float org, int& i0, int& i1) const {
+        i0 = static_cast<int>(std::floor((lo - org) / cellSize));
+        i1 = static_cast<int>(std::ceil((hi - org) / cellSize)) - 1;
+    }
+
+    bool overlapsRect(const sf::FloatRect& r) const {
+        if (empty()) return false;
+        int x0, x1, y0, y1;
+        cellRange(r.position.x, r.position.x + r.size.x, origin.x, x0, x1);
+        cellRange(r.position.y, r.position.y + r.size.y, origin.y, y0, y1);
+        y0 = std::max(y0, 0);
+        y1 = std::min(y1, rows - 1);
+        for (int y = y0; y <= y1; ++y) {
+            if (rowSpanAny(y, x0, x1)) return true;
+        }
+        return false;
+    }
+
+    // Same contract as circleIntersectsRect against every solid cell, but one
+    // masked span test per row: the circle's chord over that row's band.
+    bool overlapsCircle(const sf::Vector2f& c, float r) const {
+        if (empty()) return false;
+        int y0, y1;
+        cellRange(c.y - r, c.y + r, origin.y, y0, y1);
+        y0 = std::max(y0, 0);
+        y1 = std::min(y1, rows - 1);
+
+        for (int y = y0; y <= y1; ++y) {
+            float top = origin.y + y * cellSize;
+            float bottom = top + cellSize;
+            float dy = std::max({ 0.f, top - c.y, c.y - bottom });
+            if (dy >= r) continue;
+
+            float half = std::sqrt(r * r - dy * dy);
+            int x0, x1;
+            cellRange(c.x - half, c.x + half, origin.x, x0, x1);
+            if (rowSpanAny(y, x0, x1)) return true;
+        }
+        return false;
+    }
+
+    // ---------------- Boundary extraction ----------------
+    // Marching squares over the cell lattice, kept axis-aligned so the light
+    // follows exactly the same outline that collision uses. Each edge bit
+    // marks one unit step of the contour; consecutive bits are merged into
+    // one long Segment, found with bit scans rather than per-cell loops.
+    std::vector<Segment> extractBoundary() const {
+        std::vector<Segment> segs;
+        if (empty()) return segs;
+
+        std::vector<std::uint64_t> zero(wordsPerRow, 0);
+        std::vector<std::uint64_t> edge(wordsPerRow);
+
+        auto emitRuns = [&](const std::vector<std::uint64_t>& mask, auto&& emit) {
+            int x = 0;
+            const int n = wordsPerRow * 64;
+            while (x < n) {
+                x = scanBits(mask, x, true);
+                if (x >= n) break;
+                int end = scanBits(mask, x, false);
+                emit(x, end);
+                x = end;
+            }
+            };
+
+        // Horizontal contour pieces along the top edge of row y (y == rows is the bottom border).
+        for (int y = 0; y <= rows; ++y) {
+            const std::uint64_t* above = y > 0 ? row(y - 1) : zero.data();
+            const std::uint64_t* below = y < rows ? row(y) : zero.data();
+            float wy = origin.y + y * cellSize;
+
+            for (int pass = 0; pass < 2; ++pass) {
+                for (int w = 0; w < wordsPerRow; ++w) {
+                    edge[w] = pass == 0 ? (above[w] & ~below[w]) : (below[w] & ~above[w]);
+                }
+                emitRuns(edge, [&](int x0, int x1) {
+                    segs.push_back({ { origin.x + x0 * cellSize, wy }, { origin.x + x1 * cellSize, wy } });
+                    });
+            }
+        }
+
+        // Vertical contour pieces along the left edge of column x (x == cols is the right border).
+        // A row's boundary mask is row ^ (row << 1); a run only starts or ends where that
+        // mask changes between rows, so only the changed bits are visited.
+        std::vector<std::uint64_t> prevL(wordsPerRow, 0), prevR(wordsPerRow, 0);
+        std::vector<std::uint64_t> curL(wordsPerRow), curR(wordsPerRow), changed(wordsPerRow);
+        std::vector<int> startL(static_cast<std::size_t>(wordsPerRow) * 64, -1);
+        std::vector<int> startR(static_cast<std::size_t>(wordsPerRow) * 64, -1);
+
+        auto closeRuns = [&](const std::vector<std::uint64_t>& prev, const std::vector<std::uint64_t>& cur,
+            std::vector<int>& start, int y) {
+                for (int w = 0; w < wordsPerRow; ++w) changed[w] = prev[w] ^ cur[w];
+                emitRuns(changed, [&](int x0, int x1) {
+                    for (int x = x0; x < x1; ++x) {
+                        bool on = (cur[x >> 6] >> (x & 63)) & 1u;
+                        if (on) {
+                            start[x] = y;
+                        }
+                        else {
+                            float wx = origin.x + x * cellSize;
+                            segs.push_back({ { wx, origin.y + start[x] * cellSize }, { wx, origin.y + y * cellSize } });
+                            start[x] = -1;
+                        }
+                    }
+                    });
+            };
+
+        for (int y = 0; y <= rows; ++y) {
+            if (y < rows) {
+                const std::uint64_t* r = row(y);
+                std::uint64_t carry = 0;
+                for (int w = 0; w < wordsPerRow; ++w) {
+                    std::uint64_t shifted = (r[w] << 1) | carry;   // bit x = cell x-1
+                    carry = r[w] >> 63;
+                    curL[w] = shifted & ~r[w];                      // solid on the left
+                    curR[w] = r[w] & ~shifted;                      // solid on the right
+                }
+            }
+            else {
+                std::fill(curL.begin(), curL.end(), 0);
+                std::fill(curR.begin(), curR.end(), 0);
+            }
+
+            closeRuns(prevL, curL, startL, y);
+            closeRuns(prevR, curR, startR, y);
+            prevL.swap(curL);
+            prevR.swap(curR);
+        }
+
+        return segs;
+    }
+
+private:
+    // First bit index >= from whose value equals 'value' (wordsPerRow * 64 if none).
+    int scanBits(const std::vector<std::uint64_t>& mask, int from, bool value) const {
+        const int n = wordsPerRow * 64;
+        int w = from >> 6;
+        if (w >= wordsPerRow) return n;
+
+        std::uint64_t cur = value ? mask[w] : ~mask[w];
+        cur &= ~std::uint64_t(0) << (from & 63);
+        while (true) {
+            if (cur) return w * 64 + std::countr_zero(cur);
+            if (++w >= wordsPerRow) return n;
+            cur = value ? mask[w] : ~mask[w];
+        }
+    }
+};
+
+// Paint a grid from text rows: '#' is solid, anything else is empty.
+inline OccupancyGrid buildOccupancyGrid(const std::vector<std::string>& tileRows, float cellSize) {
+    OccupancyGrid g;
+    int cols = 0;
+    for (const auto& r : tileRows) cols = std::max(cols, static_cast<int>(r.size()));
+    g.reset(cols, static_cast<int>(tileRows.size()), cellSize);
+
+    for (int y = 0; y < g.rows; ++y) {
+        const std::string& r = tileRows[y];
+        for (int x = 0; x < static_cast<int>(r.size()); ++x) {
+            if (r[x] == '#') g.set(x, y, true);
+        }
+    }
+    return g;
+}
@@ -0,0 +1,322 @@
+// PathGraph.h
+// Any-angle shortest paths for a disc of fixed radius (the player).
+//
+// Shrinking the disc to a point grows every wall by its radius, and a
+// shortest path between two points then bends only at convex corners of the
+// grown walls. The graph's nodes are those corners, pushed out a pixel so they
+// test free; circles grow into octagons. An edge joins two nodes with a clear
+// straight path between them (WorldGeometry::hasClearPath), but only where
+// the line grazes both corners: one that cuts into a corner can never be part
+// of a shortest path, and that cheap test skips most pairs before the line of
+// sight one. Both are built once per level, the remaining tests spread over
+// worker threads by row.
+// A query links start and goal to the nodes they can see and runs A* with the
+// straight-line distance as heuristic, so a path costs two node sweeps plus a
+// search over a graph of a few hundred nodes instead of thousands of cells.
+// The graph is shared read-only between threads, so the search's working
+// arrays live in a Search the caller keeps and passes to every query.
+
+#pragma once
+
+#include "WorldGeometry.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory_resource>
+#include <thread>
+#include <vector>
+
+class PathGraph {
+public:
+    static constexpr std::size_t MAX_NODES = 4096;   // edge tests grow with the square; bigger levels go without
+    static constexpr float MARGIN = 1.f;             // px beyond the grown corner
+
+    // Per-query working arrays, sized on first use and reused after that.
+    // One per thread of queries.
+    struct Search {
+        std::vector<float> toGoal;   // >= 0: node sees the goal
+        std::vector<float> g;
+        std::vector<std::uint32_t> parent;
+        std::vector<std::uint8_t> closed;
+        std::vector<std::pair<float, std::uint32_t>> open;   // min-heap of f, node
+    };
+
+    struct Stats {
+        std::size_t nodes = 0;
+        std::size_t edges = 0;
+        double buildMs = 0.0;
+    };
+
+    PathGraph() = default;
+    explicit PathGraph(std::pmr::memory_resource* mem) : nodes(mem), sides(mem), adjFirst(mem), adj(mem), adjLen(mem) {}
+
+    // Empty, with the storage handed back to the resource.
+    void clear() {
+        world = nullptr;
+        std::pmr::vector<sf::Vector2f>(nodes.get_allocator()).swap(nodes);
+        std::pmr::vector<Corner>(sides.get_allocator()).swap(sides);
+        std::pmr::vector<std::uint32_t>(adjFirst.get_allocator()).swap(adjFirst);
+        std::pmr::vector<std::uint32_t>(adj.get_allocator()).swap(adj);
+        std::pmr::vector<float>(adjLen.get_allocator()).swap(adjLen);
+        st = Stats{};
+    }
+
+    // Corners of everything in 'w' grown by 'radius', linked where a disc of
+    // that radius can pass. threads = 0 uses every core. Returns false when
+    // the level has more than MAX_NODES corners; paths are straight lines then.
+    bool build(const WorldGeometry& w, sf::Vector2f worldSize, float radius, unsigned threads = 0) {
+        auto t0 = std::chrono::steady_clock::now();
+        clear();
+        world = &w;
+        r = radius;
+
+        // Gathered and filtered on the heap; the kept ones are stored once
+        std::vector<sf::Vector2f> pts;
+        std::vector<Corner> wedges;
+        collectCorners(w, radius + MARGIN, pts, wedges);
+        std::size_t kept = 0;
+        for (std::size_t i = 0; i < pts.size(); ++i) {
+            sf::Vector2f p = pts[i];
+            if (p.x < radius || p.y < radius || p.x > worldSize.x - radius || p.y > worldSize.y - radius || w.circleBlocked(p, radius)) continue;
+            pts[kept] = p;
+            wedges[kept++] = wedges[i];
+        }
+        if (kept > MAX_NODES) {
+            std::cout << "Path graph: " << kept << " corners exceed " << MAX_NODES << "; using straight paths.\n";
+            clear();
+            return false;
+        }
+        nodes.assign(pts.begin(), pts.begin() + kept);
+        sides.assign(wedges.begin(), wedges.begin() + kept);
+
+        // Row i tests the nodes after it; rows are handed out one at a time
+        // since the early ones are the long ones.
+        const std::size_t n = nodes.size();
+        std::vector<std::vector<std::uint32_t>> upper(n);
+        std::atomic<std::size_t> nextRow{ 0 };
+        auto worker = [&] {
+            for (std::size_t i; (i = nextRow.fetch_add(1, std::memory_order_relaxed)) < n;) {
+                for (std::size_t j = i + 1; j < n; ++j) {
+                    if (grazes(i, nodes[j]) && grazes(j, nodes[i]) && w.hasClearPath(nodes[i], nodes[j], r)) upper[i].push_back(static_cast<std::uint32_t>(j));
+                }
+            }
+            };
+        unsigned count = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+        std::vector<std::thread> pool;
+        for (unsigned t = 1; t < count; ++t) pool.emplace_back(worker);
+        worker();
+        for (auto& t : pool) t.join();
+
+        // Both directions, as CSR
+        adjFirst.assign(n + 1, 0);
+        for (std::size_t i = 0; i < n; ++i) {
+            adjFirst[i + 1] += static_cast<std::uint32_t>(upper[i].size());
+            for (std::uint32_t j : upper[i]) adjFirst[j + 1]++;
+        }
+        for (std::size_t i = 0; i < n; ++i) adjFirst[i + 1] += adjFirst[i];
+        adj.resize(adjFirst[n]);
+        adjLen.resize(adjFirst[n]);
+        std::vector<std::uint32_t> fill(adjFirst.begin(), adjFirst.end() - 1);
+        for (std::uint32_t i = 0; i < n; ++i) {
+            for (std::uint32_t j : upper[i]) {
+                float len = distance(nodes[i], nodes[j]);
+                adj[fill[i]] = j; adjLen[fill[i]++] = len;
+                adj[fill[j]] = i; adjLen[fill[j]++] = len;
+            }
+        }
+
+        st.nodes = n;
+        st.edges = adj.size() / 2;
+        st.buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        return true;
+    }
+
+    // A free start or goal can still sit inside the square or octagon that
+    // stands in for a rounded corner, where every line to the node "enters";
+    // near the node the graze test is skipped.
+    bool canLink(std::size_t i, sf::Vector2f p) const {
+        sf::Vector2f d = p - nodes[i];
+        return d.x * d.x + d.y * d.y < sides[i].reach * sides[i].reach || grazes(i, p);
+    }
+
+    // Shortest route from 'start' to 'goal' for the disc: the waypoints after
+    // 'start', ending with 'goal'. When none is known (goal walled off, no
+    // graph) 'out' is just { goal } and the result is false.
+    bool findPath(sf::Vector2f start, sf::Vector2f goal, std::vector<sf::Vector2f>& out, Search& search) const {
+        out.clear();
+        if (!world || world->hasClearPath(start, goal, r)) {
+            out.push_back(goal);
+            return world != nullptr;
+        }
+
+        // Node n is the goal; the start is the root and never revisited
+        const std::uint32_t n = static_cast<std::uint32_t>(nodes.size());
+        const std::uint32_t NONE = std::numeric_limits<std::uint32_t>::max();
+        auto& toGoal = search.toGoal;
+        auto& g = search.g;
+        auto& parent = search.parent;
+        auto& closed = search.closed;
+        auto& open = search.open;
+        toGoal.assign(n, -1.f);
+        g.assign(n + 1, std::numeric_limits<float>::infinity());
+        parent.assign(n + 1, NONE);
+        closed.assign(n + 1, 0);
+        open.clear();
+        const auto later = std::greater<std::pair<float, std::uint32_t>>();
+        auto push = [&](float f, std::uint32_t v) { open.push_back({ f, v }); std::push_heap(open.begin(), open.end(), later); };
+
+        bool goalVisible = false;
+        for (std::uint32_t i = 0; i < n; ++i) {
+            if (canLink(i, goal) && world->hasClearPath(nodes[i], goal, r)) { toGoal[i] = distance(nodes[i], goal); goalVisible = true; }
+        }
+        if (!goalVisible) { out.push_back(goal); return false; }
+        for (std::uint32_t i = 0; i < n; ++i) {
+            if (!canLink(i, start) || !world->hasClearPath(start, nodes[i], r)) continue;
+            g[i] = distance(start, nodes[i]);
+            push(g[i] + distance(nodes[i], goal), i);
+        }
+
+        while (!open.empty()) {
+            std::pop_heap(open.begin(), open.end(), later);
+            const std::uint32_t u = open.back().second;
+            open.pop_back();
+            if (closed[u]) continue;
+            closed[u] = 1;
+            if (u == n) break;
+
+            if (toGoal[u] >= 0.f && g[u] + toGoal[u] < g[n]) {
+                g[n] = g[u] + toGoal[u];
+                parent[n] = u;
+                push(g[n], n);
+            }
+            for (std::uint32_t k = adjFirst[u]; k < adjFirst[u + 1]; ++k) {
+                std::uint32_t v = adj[k];
+                float gv = g[u] + adjLen[k];
+                if (closed[v] || gv >= g[v]) continue;
+                g[v] = gv;
+                parent[v] = u;
+                push(gv + distance(nodes[v], goal), v);
+            }
+        }
+        if (parent[n] == NONE) { out.push_back(goal); return false; }
+
+        for (std::uint32_t v = parent[n]; v != NONE; v = parent[v]) out.push_back(nodes[v]);
+        std::reverse(out.begin(), out.end());
+        out.push_back(goal);
+        return true;
+    }
+
+    const Stats& stats() const { return st; }
+    const std::pmr::vector<sf::Vector2f>& corners() const { return nodes; }
+
+private:
+    static float distance(sf::Vector2f a, sf::Vector2f b) {
+        sf::Vector2f d = b - a;
+        return std::sqrt(d.x * d.x + d.y * d.y);
+    }
+
+    // Whether the line from node i towards 'p' keeps both of the corner's
+    // sides on one side of it, i.e. touches the grown shape without entering.
+    // The cross products are p's distances from the two side lines; points in
+    // the MARGIN band (a start hugging a wall) still count as outside.
+    bool grazes(std::size_t i, sf::Vector2f p) const {
+        sf::Vector2f d = p - nodes[i];
+        const Corner& e = sides[i];
+        const float tol = 2.f * MARGIN;
+        float c1 = d.x * e.a.y - d.y * e.a.x;
+        float c2 = d.x * e.b.y - d.y * e.b.x;
+        return !((c1 > tol && c2 < -tol) || (c1 < -tol && c2 > tol));
+    }
+
+    struct Corner {
+        sf::Vector2f a, b;   // unit directions of the two sides, away from the node
+        float reach;         // start/goal links closer than this skip the graze test
+    };
+
+    // Convex corners of every shape grown by 'grow', each with the directions
+    // of the two sides that meet there and how far from the node the stand-in
+    // corner strays outside the true grown shape. Square corners stand in for
+    // the rounded ones; they lie just outside it.
+    static void collectCorners(const WorldGeometry& w, float grow, std::vector<sf::Vector2f>& pts, std::vector<Corner>& wedges) {
+        auto addCorner = [&](sf::Vector2f p, sf::Vector2f sideA, sf::Vector2f sideB, float reach) {
+            pts.push_back(p);
+            wedges.push_back({ normalize(sideA), normalize(sideB), reach });
+            };
+
+        for (const auto& b : w.rects) {
+            float x0 = b.position.x - grow, y0 = b.position.y - grow;
+            float x1 = b.position.x + b.size.x + grow, y1 = b.position.y + b.size.y + grow;
+            addCorner({ x0, y0 }, { 1.f, 0.f }, { 0.f, 1.f }, 2.f * grow);
+            addCorner({ x1, y0 }, { -1.f, 0.f }, { 0.f, 1.f }, 2.f * grow);
+            addCorner({ x1, y1 }, { -1.f, 0.f }, { 0.f, -1.f }, 2.f * grow);
+            addCorner({ x0, y1 }, { 1.f, 0.f }, { 0.f, -1.f }, 2.f * grow);
+        }
+
+        for (const auto& p : w.polys) {
+            const std::size_t m = p.pts.size();
+            if (m < 3) continue;
+            sf::Vector2f centre;
+            for (const auto& v : p.pts) centre += v;
+            centre = centre / static_cast<float>(m);
+            auto outward = [&](sf::Vector2f a, sf::Vector2f b) {
+                sf::Vector2f nrm = normalize({ b.y - a.y, a.x - b.x });
+                sf::Vector2f mid = (a + b) * 0.5f - centre;
+                return nrm.x * mid.x + nrm.y * mid.y < 0.f ? -nrm : nrm;
+                };
+            for (std::size_t i = 0; i < m; ++i) {
+                const sf::Vector2f& prev = p.pts[(i + m - 1) % m];
+                const sf::Vector2f& cur = p.pts[i];
+                const sf::Vector2f& next = p.pts[(i + 1) % m];
+                sf::Vector2f n1 = outward(prev, cur), n2 = outward(cur, next);
+                // Where the two grown sides meet
+                float k = grow / std::max(0.05f, 1.f + n1.x * n2.x + n1.y * n2.y);
+                sf::Vector2f off = (n1 + n2) * k;
+                addCorner(cur + off, prev - cur, next - cur, 2.f * std::sqrt(off.x * off.x + off.y * off.y));
+            }
+        }
+
+        const float PI = 3.14159265f;
+        for (const auto& c : w.circles) {
+            float rad = (c.r + grow) / std::cos(PI / 8.f);
+            float side = 2.f * (c.r + grow) * std::tan(PI / 8.f);
+            auto vertex = [&](int k) {
+                float a = PI / 4.f * k;
+                return c.c + sf::Vector2f(std::cos(a), std::sin(a)) * rad;
+                };
+            for (int k = 0; k < 8; ++k) {
+                sf::Vector2f v = vertex(k);
+                addCorner(v, vertex(k - 1) - v, vertex(k + 1) - v, 1.5f * side);
+            }
+        }
+
+        // Grid vertices with exactly one solid cell around them are convex
+        // corners; the node sits diagonally away from that cell.
+        const OccupancyGrid& gr = w.grid;
+        if (gr.empty()) return;
+        auto solid = [&](int x, int y) { return x >= 0 && y >= 0 && x < gr.cols && y < gr.rows && gr.get(x, y); };
+        for (int y = 0; y <= gr.rows; ++y) {
+            for (int x = 0; x <= gr.cols; ++x) {
+                bool tl = solid(x - 1, y - 1), tr = solid(x, y - 1), bl = solid(x - 1, y), br = solid(x, y);
+                if (tl + tr + bl + br != 1) continue;
+                float dx = (tl || bl) ? 1.f : -1.f;
+                float dy = (tl || tr) ? 1.f : -1.f;
+                sf::Vector2f v(gr.origin.x + x * gr.cellSize, gr.origin.y + y * gr.cellSize);
+                addCorner(v + sf::Vector2f(dx, dy) * grow, { -dx, 0.f }, { 0.f, -dy }, 2.f * grow);
+            }
+        }
+    }
+
+    const WorldGeometry* world = nullptr;
+    float r = 0.f;
+    std::pmr::vector<sf::Vector2f> nodes;
+    std::pmr::vector<Corner> sides;   // parallel to nodes
+    std::pmr::vector<std::uint32_t> adjFirst;   // edges of node i: adj[adjFirst[i] .. adjFirst[i + 1])
+    std::pmr::vector<std::uint32_t> adj;
+    std::pmr::vector<float> adjLen;
+    Stats st;
+};
@@ -0,0 +1,165 @@
+// PerfCounters.h
+// Hardware performance counters around a profiled zone (Linux perf_event_open).
+//
+// One PerfCounterGroup is a perf event group led by the cycle counter, with
+// instructions, cache misses and branch misses as members, counting this
+// thread in user space only. begin()/end() reset, enable and disable the
+// whole group, so the four numbers always cover the same instructions.
+// Counters the CPU or VM does not expose are simply left out; if cycles
+// cannot be opened at all (other OS, perf_event_paranoid, no PMU) the group
+// stays unavailable and begin()/end() do nothing.
+
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+struct PerfSample {
+    std::uint64_t cycles = 0;
+    std::uint64_t instructions = 0;
+    std::uint64_t cacheMisses = 0;
+    std::uint64_t branchMisses = 0;
+    bool valid = false;
+
+    double ipc() const { return cycles ? static_cast<double>(instructions) / cycles : 0.0; }
+};
+
+class PerfCounterGroup {
+public:
+    enum Counter { Cycles, Instructions, CacheMisses, BranchMisses, COUNTER_COUNT };
+
+    PerfCounterGroup() = default;
+    ~PerfCounterGroup() { close(); }
+
+    PerfCounterGroup(const PerfCounterGroup&) = delete;
+    PerfCounterGroup& operator=(const PerfCounterGroup&) = delete;
+
+    // Returns false (with a note on stdout) when counters are unavailable.
+    bool open() {
+#ifdef __linux__
+        close();
+        static const std::uint64_t CONFIGS[COUNTER_COUNT] = {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES };
+
+        for (int c = 0; c < COUNTER_COUNT; ++c) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = CONFIGS[c];
+            attr.disabled = c == Cycles ? 1 : 0;   // members follow the leader
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            int groupFd = c == Cycles ? -1 : fds[Cycles];
+            int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, 0));
+            if (fd < 0) {
+                if (c == Cycles) {
+                    std::cout << "Perf counters: perf_event_open failed (" << std::strerror(errno)
+                        << "); no PMU, or blocked by kernel.perf_event_paranoid.\n";
+                    return false;
+                }
+                std::cout << "Perf counters: " << counterName(static_cast<Counter>(c)) << " not available.\n";
+                continue;
+            }
+            fds[c] = fd;
+            slot[c] = opened++;
+        }
+        return true;
+#else
+        std::cout << "Perf counters are only supported on Linux.\n";
+        return false;
+#endif
+    }
+
+    void close() {
+#ifdef __linux__
+        for (int c = COUNTER_COUNT - 1; c >= 0; --c) {
+            if (fds[c] >= 0) ::close(fds[c]);
+            fds[c] = -1;
+            slot[c] = -1;
+        }
+        opened = 0;
+#endif
+    }
+
+    bool available() const { return fds[Cycles] >= 0; }
+    bool has(Counter c) const { return fds[c] >= 0; }
+
+    void begin() {
+#ifdef __linux__
+        if (!available()) return;
+        ioctl(fds[Cycles], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(fds[Cycles], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+    }
+
+    // Stops counting and returns the counts since begin(), scaled up if the
+    // kernel had to multiplex the PMU for part of the zone.
+    PerfSample end() {
+        PerfSample s;
+#ifdef __linux__
+        if (!available()) return s;
+        ioctl(fds[Cycles], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+        std::uint64_t buf[3 + COUNTER_COUNT] = {};   // nr, time_enabled, time_running, values...
+        if (read(fds[Cycles], buf, sizeof(buf)) < static_cast<ssize_t>(3 * sizeof(std::uint64_t))) return s;
+        if (buf[0] != static_cast<std::uint64_t>(opened) || buf[2] == 0) return s;
+
+        double scale = buf[1] > buf[2] ? static_cast<double>(buf[1]) / buf[2] : 1.0;
+        auto value = [&](Counter c) -> std::uint64_t {
+            return slot[c] < 0 ? 0 : static_cast<std::uint64_t>(buf[3 + slot[c]] * scale);
+        };
+        s.cycles = value(Cycles);
+        s.instructions = value(Instructions);
+        s.cacheMisses = value(CacheMisses);
+        s.branchMisses = value(BranchMisses);
+        s.valid = true;
+#endif
+        return s;
+    }
+
+    static const char* counterName(Counter c) {
+        switch (c) {
+        case Cycles:       return "cycles";
+        case Instructions: return "instructions";
+        case CacheMisses:  return "cache-misses";
+        case BranchMisses: return "branch-misses";
+        default:           return "?";
+        }
+    }
+
+private:
+    int fds[COUNTER_COUNT] = { -1, -1, -1, -1 };
+    int slot[COUNTER_COUNT] = { -1, -1, -1, -1 };   // position in the group read
+    int opened = 0;
+};
+
+// Begins on construction, stores the sample on destruction.
+class PerfZone {
+public:
+    PerfZone(PerfCounterGroup* group, PerfSample& out) : g(group), sample(out) {
+        if (g) g->begin();
+    }
+    ~PerfZone() {
+        if (g) sample = g->end();
+    }
+
+    PerfZone(const PerfZone&) = delete;
+    PerfZone& operator=(const PerfZone&) = delete;
+
+private:
+    PerfCounterGroup* g;
+    PerfSample& sample;
+};
@@ -0,0 +1,118 @@
+// QuantizedEdges.h
+// Light-blocking edges stored as 16-bit integers relative to a chunk centre.
+//
+// Coordinates are snapped to 1/SCALE px and kept as int16 offsets from the
+// centre of the CHUNK_SIZE square the edge's midpoint falls in, so an edge is
+// 8 bytes instead of the 16 of a float Segment. Edges are grouped by chunk;
+// the chunk id of each edge rides in the BVH ShapeRef, so nothing per edge is
+// stored besides the four coordinates. Ray tests never expand an edge back to
+// world floats: the ray origin is moved into the chunk's integer frame once
+// and the hit distance scaled back, which is the only dequantization there is.
+
+#pragma once
+
+#include "Geometry.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <memory_resource>
+#include <span>
+#include <utility>
+#include <vector>
+
+struct QuantizedEdge {
+    std::int16_t ax, ay, bx, by;
+};
+static_assert(sizeof(QuantizedEdge) == 8, "QuantizedEdge should stay 8 bytes");
+
+class QuantizedEdges {
+public:
+    static constexpr float SCALE = 8.f;          // units per px (1/8 px snap)
+    static constexpr float CHUNK_SIZE = 2048.f;  // px
+    static constexpr float MAX_PIECE = 4096.f;   // longer edges are split so both ends fit in int16
+    static constexpr std::size_t MAX_CHUNKS = 65535;
+
+    std::pmr::vector<QuantizedEdge> edges;     // grouped by chunk
+    std::pmr::vector<sf::Vector2f> centers;    // per chunk, world px
+    std::pmr::vector<std::uint32_t> chunkFirst;   // per chunk + 1 sentinel: edges[chunkFirst[c] .. chunkFirst[c+1])
+
+    QuantizedEdges() = default;
+    explicit QuantizedEdges(std::pmr::memory_resource* mem) : edges(mem), centers(mem), chunkFirst(mem) {}
+
+    // Empty, with the storage handed back to the resource.
+    void clear() {
+        std::pmr::vector<QuantizedEdge>(edges.get_allocator()).swap(edges);
+        std::pmr::vector<sf::Vector2f>(centers.get_allocator()).swap(centers);
+        std::pmr::vector<std::uint32_t>(chunkFirst.get_allocator()).swap(chunkFirst);
+    }
+    bool empty() const { return edges.empty(); }
+    std::size_t chunkCount() const { return centers.size(); }
+    std::size_t bytes() const {
+        return edges.size() * sizeof(QuantizedEdge) + centers.size() * sizeof(sf::Vector2f) + chunkFirst.size() * sizeof(std::uint32_t);
+    }
+
+    // Returns false (and stays empty) if the level touches more chunks than a
+    // 16-bit chunk id can name; the caller keeps float edges then.
+    bool build(std::span<const Segment> segs) {
+        clear();
+        std::map<std::pair<int, int>, std::vector<Segment>> byChunk;   // ordered, so builds are repeatable
+        for (const Segment& s : segs) {
+            sf::Vector2f d = s.b - s.a;
+            float len = std::sqrt(d.x * d.x + d.y * d.y);
+            int pieces = std::max(1, static_cast<int>(std::ceil(len / MAX_PIECE)));
+            for (int k = 0; k < pieces; ++k) {
+                Segment p{ s.a + d * (static_cast<float>(k) / pieces), s.a + d * (static_cast<float>(k + 1) / pieces) };
+                sf::Vector2f mid = (p.a + p.b) * 0.5f;
+                byChunk[{ static_cast<int>(std::floor(mid.x / CHUNK_SIZE)), static_cast<int>(std::floor(mid.y / CHUNK_SIZE)) }].push_back(p);
+            }
+        }
+        if (byChunk.size() > MAX_CHUNKS) {
+            std::cout << "Quantized edges: " << byChunk.size() << " chunks exceed 16-bit ids; keeping float edges.\n";
+            return false;
+        }
+
+        std::size_t pieces = 0;
+        for (const auto& [key, list] : byChunk) pieces += list.size();
+        edges.reserve(pieces);
+        centers.reserve(byChunk.size());
+        chunkFirst.reserve(byChunk.size() + 1);
+        for (const auto& [key, list] : byChunk) {
+            sf::Vector2f c((key.first + 0.5f) * CHUNK_SIZE, (key.second + 0.5f) * CHUNK_SIZE);
+            centers.push_back(c);
+            chunkFirst.push_back(static_cast<std::uint32_t>(edges.size()));
+            for (const Segment& s : list) {
+                edges.push_back({ quantize(s.a.x - c.x), quantize(s.a.y - c.y), quantize(s.b.x - c.x), quantize(s.b.y - c.y) });
+            }
+        }
+        chunkFirst.push_back(static_cast<std::uint32_t>(edges.size()));
+        return true;
+    }
+
+    Segment segment(std::uint16_t chunk, std::uint32_t i) const {
+        const QuantizedEdge& e = edges[i];
+        sf::Vector2f c = centers[chunk];
+        const float inv = 1.f / SCALE;
+        return { { c.x + e.ax * inv, c.y + e.ay * inv }, { c.x + e.bx * inv, c.y + e.by * inv } };
+    }
+
+    // Ray origin + t*dir against edge i of 'chunk', in the chunk's integer frame.
+    bool raycast(std::uint16_t chunk, std::uint32_t i, sf::Vector2f origin, sf::Vector2f dir, float& t) const {
+        const QuantizedEdge& e = edges[i];
+        sf::Vector2f o = (origin - centers[chunk]) * SCALE;
+        sf::Vector2f q(static_cast<float>(e.ax), static_cast<float>(e.ay));
+        sf::Vector2f s(static_cast<float>(e.bx - e.ax), static_cast<float>(e.by - e.ay));
+        float tq;
+        sf::Vector2f hp;
+        if (!raySegmentIntersect(o, dir, q, s, tq, hp)) return false;
+        t = tq * (1.f / SCALE);
+        return true;
+    }
+
+private:
+    static std::int16_t quantize(float px) {
+        float v = std::round(px * SCALE);
+        return static_cast<std::int16_t>(std::clamp(v, -32768.f, 32767.f));
+    }
+};
@@ -0,0 +1,325 @@
+// RenderQueue.h
+// Draw commands recorded on several threads, submitted in state order on one.
+//
+// record() hands jobs out to a few worker threads (and the calling thread);
+// each thread owns a Recorder that flattens what it is given (shapes,
+// sprites, vertex arrays) into triangles tagged with a layer, a blend mode
+// and a texture. Recording touches no GL state, so it is safe off the render
+// thread; anything that does (sf::Text lays out glyphs on first use) is
+// recorded from the render thread through direct().
+//
+// submit() runs on the render thread. It sorts the commands of the layers it
+// is asked for by layer, blend mode and texture, keeping recording order
+// (job, then call) among equal states, and draws each run of equal state as
+// one batch. Painter's order therefore only holds between layers and within
+// one state: things that must overlap a differently drawn thing in a fixed
+// order go on separate layers.
+
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class RenderQueue {
+public:
+    // Sort order within a layer; ERASE_BLEND and ADD_GLOW in the game
+    enum class Blend : std::uint8_t { Alpha, Erase, Glow };
+    static constexpr std::size_t BLEND_COUNT = 3;
+
+    struct Stats {
+        std::size_t commands = 0;   // recorded state runs, after merging within a recorder
+        std::size_t batches = 0;    // draw calls issued
+        std::size_t vertices = 0;
+        std::size_t jobs = 0;
+        std::size_t threads = 0;
+    };
+
+    class Recorder {
+    public:
+        // Raw triangles (count a multiple of 3) in the layer's coordinates.
+        void triangles(std::uint8_t layer, Blend blend, const sf::Texture* texture, const sf::Vertex* v, std::size_t count) {
+            Command& c = open(layer, blend, texture, false);
+            vertices.insert(vertices.end(), v, v + count);
+            c.count += static_cast<std::uint32_t>(count);
+        }
+
+        // Triangles, fans and strips; anything else is ignored.
+        void vertexArray(std::uint8_t layer, Blend blend, const sf::VertexArray& va, const sf::Texture* texture = nullptr) {
+            const std::size_t n = va.getVertexCount();
+            if (n < 3) return;
+            Command& c = open(layer, blend, texture, false);
+            const std::size_t before = vertices.size();
+            switch (va.getPrimitiveType()) {
+            case sf::PrimitiveType::Triangles:
+                for (std::size_t i = 0; i + 2 < n; i += 3) vertices.insert(vertices.end(), { va[i], va[i + 1], va[i + 2] });
+                break;
+            case sf::PrimitiveType::TriangleFan:
+                for (std::size_t i = 1; i + 1 < n; ++i) vertices.insert(vertices.end(), { va[0], va[i], va[i + 1] });
+                break;
+            case sf::PrimitiveType::TriangleStrip:
+                for (std::size_t i = 0; i + 2 < n; ++i) vertices.insert(vertices.end(), { va[i], va[i + 1], va[i + 2] });
+                break;
+            default:
+                break;
+            }
+            c.count += static_cast<std::uint32_t>(vertices.size() - before);
+        }
+
+        // Fill only, untextured, as a fan around point 0 (shapes are convex).
+        void shape(std::uint8_t layer, const sf::Shape& s) {
+            const std::size_t n = s.getPointCount();
+            if (n < 3) return;
+            Command& c = open(layer, Blend::Alpha, nullptr, false);
+            const sf::Transform& xf = s.getTransform();
+            const sf::Color col = s.getFillColor();
+            const sf::Vector2f p0 = xf.transformPoint(s.getPoint(0));
+            sf::Vector2f prev = xf.transformPoint(s.getPoint(1));
+            for (std::size_t i = 2; i < n; ++i) {
+                sf::Vector2f p = xf.transformPoint(s.getPoint(i));
+                vertices.insert(vertices.end(), { sf::Vertex{ p0, col, {} }, sf::Vertex{ prev, col, {} }, sf::Vertex{ p, col, {} } });
+                prev = p;
+            }
+            c.count += static_cast<std::uint32_t>(3 * (n - 2));
+        }
+
+        // Same quad and texture coordinates SFML builds for the sprite.
+        void sprite(std::uint8_t layer, const sf::Sprite& s, Blend blend = Blend::Alpha) {
+            const sf::IntRect& r = s.getTextureRect();
+            const float w = static_cast<float>(std::abs(r.size.x)), h = static_cast<float>(std::abs(r.size.y));
+            const float left = static_cast<float>(r.position.x), right = left + static_cast<float>(r.size.x);
+            const float top = static_cast<float>(r.position.y), bottom = top + static_cast<float>(r.size.y);
+            const sf::Transform& xf = s.getTransform();
+            const sf::Color col = s.getColor();
+            const sf::Vertex q[4] = {
+                { xf.transformPoint({ 0.f, 0.f }), col, { left, top } },
+                { xf.transformPoint({ 0.f, h }), col, { left, bottom } },
+                { xf.transformPoint({ w, 0.f }), col, { right, top } },
+                { xf.transformPoint({ w, h }), col, { right, bottom } },
+            };
+            Command& c = open(layer, blend, &s.getTexture(), false);
+            vertices.insert(vertices.end(), { q[0], q[1], q[2], q[2], q[1], q[3] });
+            c.count += 6;
+        }
+
+        // Kept whole and drawn in its sorted place; never merged.
+        void text(std::uint8_t layer, const sf::Text& t) {
+            Command& c = open(layer, Blend::Alpha, nullptr, true);
+            c.first = static_cast<std::uint32_t>(texts.size());
+            c.count = 1;
+            texts.push_back(t);
+        }
+
+    private:
+        friend class RenderQueue;
+
+        struct Command {
+            std::uint8_t layer;
+            Blend blend;
+            bool isText;
+            const sf::Texture* texture;
+            std::uint32_t job;
+            std::uint32_t seq;
+            std::uint32_t first;   // into vertices (or texts)
+            std::uint32_t count;
+        };
+
+        // Extends the last command when the state is unchanged, so a job's
+        // consecutive same-state records are one command already.
+        Command& open(std::uint8_t layer, Blend blend, const sf::Texture* texture, bool isText) {
+            if (!isText && !commands.empty()) {
+                Command& last = commands.back();
+                if (!last.isText && last.job == job && last.layer == layer && last.blend == blend && last.texture == texture) return last;
+            }
+            commands.push_back({ layer, blend, isText, texture, job, seq++, static_cast<std::uint32_t>(vertices.size()), 0 });
+            return commands.back();
+        }
+
+        void clear() {
+            commands.clear();
+            vertices.clear();
+            texts.clear();
+        }
+
+        std::vector<Command> commands;
+        std::vector<sf::Vertex> vertices;
+        std::vector<sf::Text> texts;
+        std::uint32_t job = 0;
+        std::uint32_t seq = 0;
+    };
+
+    // 'workers' extra threads; the thread calling record() is one more.
+    explicit RenderQueue(unsigned workers = defaultWorkers()) {
+        recorders.resize(workers + 1);
+        for (unsigned i = 0; i < workers; ++i) pool.emplace_back([this, i] { workerLoop(i + 1); });
+        blendModes[static_cast<std::size_t>(Blend::Alpha)] = sf::BlendAlpha;
+        blendModes[static_cast<std::size_t>(Blend::Erase)] = sf::BlendAlpha;
+        blendModes[static_cast<std::size_t>(Blend::Glow)] = sf::BlendAdd;
+    }
+
+    ~RenderQueue() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            quit = true;
+        }
+        wake.notify_all();
+        for (auto& t : pool) t.join();
+    }
+
+    RenderQueue(const RenderQueue&) = delete;
+    RenderQueue& operator=(const RenderQueue&) = delete;
+
+    static unsigned defaultWorkers() {
+        unsigned hw = std::thread::hardware_concurrency();
+        return std::min(3u, hw > 1 ? hw - 1 : 0u);
+    }
+
+    void setBlendMode(Blend b, const sf::BlendMode& mode) { blendModes[static_cast<std::size_t>(b)] = mode; }
+
+    // Start a frame: drop everything recorded so far.
+    void clear() {
+        for (auto& r : recorders) r.clear();
+        nextJobId = 0;
+        st = Stats{};
+        st.threads = recorders.size();
+    }
+
+    // Run job(i, recorder) for i in [0, jobs) spread over the threads, and
+    // return once all are done. Jobs are ordered among themselves by i.
+    void record(std::size_t jobs, const std::function<void(std::size_t, Recorder&)>& job) {
+        if (jobs == 0) return;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            task = &job;
+            taskJobs = jobs;
+            taskBase = nextJobId;
+            nextJob.store(0, std::memory_order_relaxed);
+            busy = pool.size();
+            generation++;
+        }
+        wake.notify_all();
+        runJobs(0);
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            done.wait(lock, [&] { return busy == 0; });
+            task = nullptr;
+        }
+        nextJobId += static_cast<std::uint32_t>(jobs);
+        st.jobs += jobs;
+    }
+
+    // Record from the render thread, ordered after every job so far.
+    Recorder& direct() {
+        Recorder& r = recorders[0];
+        r.job = nextJobId++;
+        r.seq = 0;
+        return r;
+    }
+
+    // Draw the commands of layers [first, last] to 'target' with its current view.
+    void submit(sf::RenderTarget& target, std::uint8_t first, std::uint8_t last) {
+        order.clear();
+        for (const auto& r : recorders) {
+            for (const auto& c : r.commands) {
+                if (c.layer >= first && c.layer <= last && c.count > 0) order.push_back({ &r, &c });
+            }
+        }
+        std::sort(order.begin(), order.end(), [](const Ref& a, const Ref& b) {
+            const Recorder::Command& x = *a.cmd;
+            const Recorder::Command& y = *b.cmd;
+            if (x.layer != y.layer) return x.layer < y.layer;
+            if (x.blend != y.blend) return x.blend < y.blend;
+            if (x.isText != y.isText) return y.isText;
+            if (x.texture != y.texture) return std::less<const sf::Texture*>()(x.texture, y.texture);
+            if (x.job != y.job) return x.job < y.job;
+            return x.seq < y.seq;
+            });
+        st.commands += order.size();
+
+        for (std::size_t i = 0; i < order.size();) {
+            const Recorder::Command& head = *order[i].cmd;
+            sf::RenderStates states(blendModes[static_cast<std::size_t>(head.blend)]);
+            if (head.isText) {
+                target.draw(order[i].rec->texts[head.first], states);
+                st.batches++;
+                ++i;
+                continue;
+            }
+            states.texture = head.texture;
+            batch.clear();
+            std::size_t j = i;
+            for (; j < order.size(); ++j) {
+                const Recorder::Command& c = *order[j].cmd;
+                if (c.isText || c.layer != head.layer || c.blend != head.blend || c.texture != head.texture) break;
+                const sf::Vertex* v = order[j].rec->vertices.data() + c.first;
+                batch.insert(batch.end(), v, v + c.count);
+            }
+            target.draw(batch.data(), batch.size(), sf::PrimitiveType::Triangles, states);
+            st.batches++;
+            st.vertices += batch.size();
+            i = j;
+        }
+    }
+
+    const Stats& stats() const { return st; }
+
+private:
+    struct Ref {
+        const Recorder* rec;
+        const Recorder::Command* cmd;
+    };
+
+    void runJobs(std::size_t self) {
+        Recorder& r = recorders[self];
+        for (std::size_t i; (i = nextJob.fetch_add(1, std::memory_order_relaxed)) < taskJobs;) {
+            r.job = taskBase + static_cast<std::uint32_t>(i);
+            r.seq = 0;
+            (*task)(i, r);
+        }
+    }
+
+    void workerLoop(std::size_t self) {
+        std::uint64_t seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                wake.wait(lock, [&] { return quit || generation != seen; });
+                if (quit) return;
+                seen = generation;
+            }
+            runJobs(self);
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                if (--busy == 0) done.notify_one();
+            }
+        }
+    }
+
+    std::vector<Recorder> recorders;   // [0] belongs to the thread calling record()
+    std::vector<std::thread> pool;
+    sf::BlendMode blendModes[BLEND_COUNT];
+    std::vector<Ref> order;
+    std::vector<sf::Vertex> batch;
+    std::uint32_t nextJobId = 0;
+    Stats st;
+
+    std::mutex mtx;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::function<void(std::size_t, Recorder&)>* task = nullptr;
+    std::size_t taskJobs = 0;
+    std::uint32_t taskBase = 0;
+    std::atomic<std::size_t> nextJob{ 0 };
+    std::size_t busy = 0;
+    std::uint64_t generation = 0;
+    bool quit = false;
+};
@@ -0,0 +1,347 @@
+// Replay.h
+// Input replays (.mgrp) and the batch verifier for leaderboard submissions.
+//
+// A replay is the input byte of every player for every fixed tick of one run,
+// plus what the run claims to have reached: the tick the level was cleared on
+// and a hash of the final GameState. simStep() is deterministic, so
+// verifying a replay is replaying it: start from makeInitialState(), feed the
+// inputs at SIM_TICK_DT and compare. The level is identified by a fingerprint
+// of its LevelDef and the SimTuning it was played with rather than its menu
+// position, so a replay recorded on an edited level or with other tuning is
+// rejected instead of verified against the wrong walls or speeds.
+//
+// BatchVerifier builds each level's geometry once, then worker threads take
+// files off a shared queue, load and replay them. Nothing is shared between
+// workers but the read-only levels and the queue index.
+//
+// Layout (little endian):
+//   'MGRP' u32 version
+//   u16 nameLen, level name bytes (for messages only)
+//   u64 level fingerprint
+//   u8 players
+//   u32 ticks (the claimed completion tick)
+//   u64 claimed final state hash
+//   ticks x players input bytes, tick-major
+
+#pragma once
+
+#include "LevelFile.h"
+#include "Sim.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace replay {
+
+    constexpr std::uint32_t MAGIC = 0x5052474Du;   // "MGRP"
+    constexpr std::uint32_t VERSION = 2;   // 2: the fingerprint covers the tuning
+    constexpr std::uint32_t MAX_TICKS = 60u * 60u * 60u;   // an hour at 60 Hz
+    // Longest name, every header field and MAX_TICKS of inputs for every player
+    constexpr std::size_t MAX_FILE_BYTES = 4 + 4 + 2 + 0xFFFF + 8 + 1 + 4 + 8 + std::size_t(MAX_TICKS) * MAX_SIM_PLAYERS;
+
+    // ---------------- Hashing ----------------
+    // FNV-1a over values, not over raw structs: GameState has padding bytes
+    // whose contents are not part of the state.
+
+    struct Fnv {
+        std::uint64_t h = 0xCBF29CE484222325ull;
+
+        void bytes(const void* data, std::size_t n) {
+            const auto* p = static_cast<const std::uint8_t*>(data);
+            for (std::size_t i = 0; i < n; ++i) { h ^= p[i]; h *= 0x100000001B3ull; }
+        }
+        template <typename T>
+        void add(const T& v) { bytes(&v, sizeof(T)); }
+        void add(sf::Vector2f v) { add(v.x); add(v.y); }
+        void count(std::size_t n) { add(static_cast<std::uint64_t>(n)); }   // same width on every platform
+    };
+
+    inline std::uint64_t hashState(const GameState& s) {
+        Fnv f;
+        f.add(s.tick);
+        f.add(static_cast<std::uint8_t>(s.status));
+        f.add(s.playerCount);
+        f.add(s.targetsLeft);
+        f.add(s.timeLeft);
+        for (int p = 0; p < s.playerCount; ++p) {
+            const PlayerState& pl = s.players[p];
+            f.add(pl.pos);
+            f.add(pl.speedBoostLeft);
+            f.add(pl.arrowLeft);
+            f.add(pl.fullLightLeft);
+            f.add(pl.collected);
+        }
+        for (std::uint64_t w : s.targetAlive) f.add(w);
+        f.add(s.powerupActive);
+        return f.h;
+    }
+
+    // Everything simStep() can observe about a level.
+    inline std::uint64_t levelFingerprint(const LevelDef& L, const SimTuning& t) {
+        Fnv f;
+        f.add(t.playerRadius);
+        f.add(t.targetRadius);
+        f.add(t.baseSpeed);
+        f.add(t.powerupRadius);
+        f.add(t.timeAddSeconds);
+        f.add(t.speedMult);
+        f.add(t.speedDuration);
+        f.add(t.arrowDuration);
+        f.add(t.fullLightDuration);
+        f.add(L.worldW);
+        f.add(L.worldH);
+        f.add(L.playerSpawn);
+        f.add(L.timeLimit);
+        f.count(L.targetSpawns.size());
+        for (const auto& spawn : L.targetSpawns) f.add(spawn);
+        f.count(L.wallRects.size());
+        for (const auto& r : L.wallRects) { f.add(r.x); f.add(r.y); f.add(r.w); f.add(r.h); }
+        f.count(L.powerups.size());
+        for (const auto& p : L.powerups) { f.add(static_cast<std::int32_t>(p.type)); f.add(p.pos); }
+        f.add(L.tileSize);
+        f.count(L.tileRows.size());
+        for (const auto& row : L.tileRows) { f.count(row.size()); f.bytes(row.data(), row.size()); }
+        f.count(L.polygons.size());
+        for (const auto& p : L.polygons) {
+            f.count(p.pts.size());
+            for (const auto& v : p.pts) f.add(v);
+        }
+        f.count(L.circles.size());
+        for (const auto& c : L.circles) { f.add(c.c); f.add(c.r); }
+        return f.h;
+    }
+
+    // ---------------- File ----------------
+
+    struct Replay {
+        std::string levelName;
+        std::uint64_t level = 0;          // levelFingerprint()
+        std::uint8_t players = 1;
+        std::uint32_t ticks = 0;
+        std::uint64_t finalHash = 0;
+        std::vector<std::uint8_t> inputs; // ticks * players
+
+        // Appends one tick's inputs (players bytes).
+        void record(const std::uint8_t* in) {
+            inputs.insert(inputs.end(), in, in + players);
+            ticks++;
+        }
+    };
+
+    inline bool saveReplay(const std::string& path, const Replay& r) {
+        using levelfile::put;
+        std::vector<std::uint8_t> out;
+        put(out, MAGIC);
+        put(out, VERSION);
+        put(out, static_cast<std::uint16_t>(r.levelName.size()));
+        out.insert(out.end(), r.levelName.begin(), r.levelName.end());
+        put(out, r.level);
+        put(out, r.players);
+        put(out, r.ticks);
+        put(out, r.finalHash);
+        out.insert(out.end(), r.inputs.begin(), r.inputs.end());
+
+        std::ofstream f(path, std::ios::binary);
+        if (!f || !f.write(reinterpret_cast<const char*>(out.data()), static_cast<std::streamsize>(out.size()))) {
+            std::cout << "Failed to write replay: " << path << "\n";
+            return false;
+        }
+        return true;
+    }
+
+    // On failure 'why' says what was wrong; nothing is printed, since the
+    // batch verifier reports per file.
+    inline bool loadReplay(const std::string& path, Replay& r, const char*& why) {
+        using levelfile::get;
+        std::ifstream f(path, std::ios::binary | std::ios::ate);
+        if (!f) { why = "cannot open"; return false; }
+        // tellg() is -1 when the size is unknown, and a directory can claim any size
+        const std::streamoff size = f.tellg();
+        if (size < 0) { why = "cannot read"; return false; }
+        if (static_cast<std::uint64_t>(size) > MAX_FILE_BYTES) { why = "too large"; return false; }
+        std::vector<std::uint8_t> data(static_cast<std::size_t>(size));
+        f.seekg(0);
+        if (!f.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()))) { why = "cannot read"; return false; }
+
+        const std::uint8_t* p = data.data();
+        const std::uint8_t* end = p + data.size();
+        std::uint32_t magic = 0, version = 0;
+        if (!get(p, end, magic) || magic != MAGIC) { why = "not a replay file"; return false; }
+        if (!get(p, end, version) || version != VERSION) { why = "unsupported version"; return false; }
+        std::uint16_t nameLen = 0;
+        if (!get(p, end, nameLen) || static_cast<std::size_t>(end - p) < nameLen) { why = "truncated header"; return false; }
+        r.levelName.assign(reinterpret_cast<const char*>(p), nameLen);
+        p += nameLen;
+        if (!get(p, end, r.level) || !get(p, end, r.players) || !get(p, end, r.ticks) || !get(p, end, r.finalHash)) {
+            why = "truncated header";
+            return false;
+        }
+        if (r.players < 1 || r.players > MAX_SIM_PLAYERS) { why = "bad player count"; return false; }
+        if (r.ticks > MAX_TICKS) { why = "too long"; return false; }
+        std::size_t bytes = static_cast<std::size_t>(r.ticks) * r.players;
+        if (static_cast<std::size_t>(end - p) != bytes) { why = "input length does not match tick count"; return false; }
+        r.inputs.assign(p, end);
+        return true;
+    }
+
+    // ---------------- Verification ----------------
+
+    enum class Verdict : std::uint8_t { Valid, Unreadable, UnknownLevel, NotCleared, ClearedEarly, WrongHash };
+
+    inline const char* verdictName(Verdict v) {
+        switch (v) {
+        case Verdict::Valid:        return "valid";
+        case Verdict::Unreadable:   return "unreadable";
+        case Verdict::UnknownLevel: return "unknown level";
+        case Verdict::NotCleared:   return "level not cleared at the claimed tick";
+        case Verdict::ClearedEarly: return "level cleared before the claimed tick";
+        case Verdict::WrongHash:    return "final state hash mismatch";
+        }
+        return "?";
+    }
+
+    // Geometry and sim data of one level, built once and only read afterwards.
+    struct VerifyLevel {
+        LevelDef def;
+        WorldGeometry world;
+        SimLevel sim;   // points into 'world', so VerifyLevel never moves
+        std::uint64_t fingerprint;
+
+        VerifyLevel(const LevelDef& L, const SimTuning& tuning) : def(L), fingerprint(levelFingerprint(L, tuning)) {
+            buildLevelGeometry(def, world);
+            sim.build(def, world, tuning);
+        }
+
+        VerifyLevel(const VerifyLevel&) = delete;
+        VerifyLevel& operator=(const VerifyLevel&) = delete;
+    };
+
+    struct Outcome {
+        Verdict verdict = Verdict::Unreadable;
+        std::uint32_t clearedTick = 0;   // 0 if the run never cleared
+        std::uint64_t finalHash = 0;
+        const char* why = nullptr;       // for Unreadable
+    };
+
+    // The run must clear the level on exactly its last tick and end in the
+    // claimed state; trailing inputs after the clear are not accepted.
+    inline Outcome verifyReplay(const VerifyLevel& level, const Replay& r) {
+        Outcome o;
+        GameState s = makeInitialState(level.sim, r.players);
+        const std::uint8_t* in = r.inputs.data();
+        for (std::uint32_t t = 0; t < r.ticks; ++t, in += r.players) {
+            simStep(level.sim, s, in, SIM_TICK_DT);
+            if (s.status != SimStatus::Playing) break;
+        }
+        o.clearedTick = s.status == SimStatus::Cleared ? s.tick : 0;
+        o.finalHash = hashState(s);
+        if (s.status != SimStatus::Cleared) o.verdict = Verdict::NotCleared;
+        else if (s.tick != r.ticks) o.verdict = Verdict::ClearedEarly;
+        else if (o.finalHash != r.finalHash) o.verdict = Verdict::WrongHash;
+        else o.verdict = Verdict::Valid;
+        return o;
+    }
+
+    class BatchVerifier {
+    public:
+        struct Config {
+            int threads = 0;        // 0 = hardware_concurrency
+            bool verbose = false;   // print valid replays too, not just the rejected ones
+            SimTuning tuning;       // what the submitted runs were played with
+        };
+
+        BatchVerifier(const std::vector<LevelDef>& levelDefs, Config cfg) : config(cfg) {
+            for (const auto& L : levelDefs) levels.push_back(std::make_unique<VerifyLevel>(L, config.tuning));
+        }
+
+        // Verifies every file, prints a line per rejected replay and a
+        // throughput summary. Returns the number of rejected replays.
+        int run(const std::vector<std::string>& files) {
+            using Clock = std::chrono::steady_clock;
+            unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+            int threadCount = config.threads > 0 ? config.threads : static_cast<int>(hw);
+            threadCount = std::clamp(threadCount, 1, std::max(1, static_cast<int>(files.size())));
+
+            std::vector<Outcome> outcomes(files.size());
+            std::vector<Worker> workers(threadCount);
+            std::atomic<std::size_t> nextFile{ 0 };
+
+            auto work = [&](Worker& w) {
+                Replay r;
+                for (std::size_t i; (i = nextFile.fetch_add(1, std::memory_order_relaxed)) < files.size();) {
+                    auto t0 = Clock::now();
+                    Outcome& o = outcomes[i];
+                    if (!loadReplay(files[i], r, o.why)) o.verdict = Verdict::Unreadable;
+                    else if (const VerifyLevel* level = find(r.level)) {
+                        auto t1 = Clock::now();
+                        o = verifyReplay(*level, r);
+                        w.simNs += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t1).count();
+                        w.ticks += o.clearedTick ? o.clearedTick : r.ticks;
+                    }
+                    else o.verdict = Verdict::UnknownLevel;
+                    w.busyNs += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count();
+                    w.replays++;
+                }
+                };
+
+            auto begin = Clock::now();
+            std::vector<std::thread> pool;
+            for (int t = 1; t < threadCount; ++t) pool.emplace_back(work, std::ref(workers[t]));
+            work(workers[0]);
+            for (auto& t : pool) t.join();
+            double wall = std::chrono::duration<double>(Clock::now() - begin).count();
+
+            int rejected = 0;
+            for (std::size_t i = 0; i < files.size(); ++i) {
+                const Outcome& o = outcomes[i];
+                if (o.verdict != Verdict::Valid) rejected++;
+                if (o.verdict != Verdict::Valid || config.verbose) {
+                    std::printf("%s: %s", files[i].c_str(), verdictName(o.verdict));
+                    if (o.why) std::printf(" (%s)", o.why);
+                    if (o.clearedTick) std::printf(" (cleared on tick %u)", o.clearedTick);
+                    std::printf("\n");
+                }
+            }
+
+            // Per core = what one fully busy core verifies per second, from the
+            // measured time per replay; wall throughput also pays for imbalance.
+            std::uint64_t busyNs = 0, simNs = 0, ticks = 0;
+            for (const auto& w : workers) { busyNs += w.busyNs; simNs += w.simNs; ticks += w.ticks; }
+            double busy = busyNs / 1e9;
+            std::printf("Verified %zu replays on %d threads in %.3f s: %d valid, %d rejected\n",
+                files.size(), threadCount, wall, static_cast<int>(files.size()) - rejected, rejected);
+            std::printf("replays/s %9.0f | replays/s per core %9.0f | ticks/s per core %11.0f | load+check %4.1f%% of busy time\n",
+                files.size() / std::max(wall, 1e-9), files.size() / std::max(busy, 1e-9),
+                ticks / std::max(simNs / 1e9, 1e-9), busyNs ? 100.0 * (busyNs - simNs) / busyNs : 0.0);
+            return rejected;
+        }
+
+    private:
+        // Padded so each worker's counters sit on their own cache line.
+        struct alignas(64) Worker {
+            std::uint64_t replays = 0;
+            std::uint64_t ticks = 0;
+            std::uint64_t busyNs = 0;
+            std::uint64_t simNs = 0;
+        };
+
+        const VerifyLevel* find(std::uint64_t fingerprint) const {
+            for (const auto& l : levels) if (l->fingerprint == fingerprint) return l.get();
+            return nullptr;
+        }
+
+        std::vector<std::unique_ptr<VerifyLevel>> levels;
+        Config config;
+    };
+
+} // namespace replay
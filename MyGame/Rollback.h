@@ -0,0 +1,221 @@
+// Rollback.h
+// GGPO-style rollback for two-player matches over UDP.
+//
+// Each side simulates immediately with its own input and a prediction of the
+// remote one (the last input actually received). Every packet carries the
+// sender's recent inputs redundantly, so a lost datagram is covered by the
+// next. When a remote input turns out to differ from what was predicted, the
+// session restores the snapshot taken before that tick and re-simulates up to
+// the present in the same frame. A side that gets more than MAX_ROLLBACK
+// ticks ahead of what it has confirmed waits for the other instead.
+//
+// The predicted state can end the match on a guess, so the result comes
+// from a second state that only ever steps with confirmed inputs: the match
+// is over when that one stops playing. Both sides reach the same confirmed
+// end tick. Ticks keep being counted (and inputs exchanged) after the
+// predicted state ends, since a rollback may still revive it; once the
+// confirmed state ends, poll() keeps resending until the peer has acked
+// every input it needs.
+
+#pragma once
+
+#include "Sim.h"
+#include <SFML/Network.hpp>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <optional>
+
+class RollbackSession {
+public:
+    static constexpr std::uint32_t MAX_ROLLBACK = 8;
+    static constexpr std::uint32_t HISTORY = 64;       // ring size, power of two
+    static constexpr std::uint32_t SEND_WINDOW = 32;   // inputs repeated per packet
+    static constexpr std::uint32_t PACKET_MAGIC = 0x314B4252u;   // "RBK1"
+
+    struct Stats {
+        std::uint64_t rollbacks = 0;
+        std::uint64_t resimTicks = 0;
+        std::uint32_t maxResimTicks = 0;
+        float lastResimUs = 0.f;
+        float maxResimUs = 0.f;
+        std::uint64_t stalls = 0;
+        std::uint64_t packetsIn = 0;
+        std::uint64_t packetsOut = 0;
+    };
+
+    // Ports are on 127.0.0.1; player 0 and 1 simply swap them.
+    bool start(const SimLevel& lvl, int localPlayerIndex, unsigned short localPort, unsigned short remotePort) {
+        level = &lvl;
+        local = localPlayerIndex & 1;
+        remote = 1 - local;
+        peerPort = remotePort;
+
+        socket.setBlocking(false);
+        if (socket.bind(localPort, sf::IpAddress::LocalHost) != sf::Socket::Status::Done) {
+            std::cout << "Rollback: cannot bind UDP port " << localPort << "\n";
+            return false;
+        }
+
+        current = makeInitialState(lvl, 2);
+        confirmed = current;
+        nextTick = 0;
+        confirmedTick = 0;
+        for (auto& in : inputs) in = { 0, 0 };
+        confirmedRemote = 0;
+        lastRemoteInput = 0;
+        remoteAck = 0;
+        stats = Stats{};
+        std::cout << "Rollback: player " << local + 1 << " on udp/" << localPort << ", peer udp/" << remotePort << "\n";
+        return true;
+    }
+
+    // One fixed tick with this local input. Returns false when we are too far
+    // ahead of the remote and waited instead (the state did not advance).
+    // Not needed (and not to be called) once finished().
+    bool advance(std::uint8_t localInput) {
+        const std::uint32_t now = nextTick;
+        std::uint32_t rollbackFrom = receive(now);
+        if (rollbackFrom < now) resimulate(rollbackFrom, now);
+        stepConfirmed();
+
+        if (now >= confirmedRemote + MAX_ROLLBACK) {
+            stats.stalls++;
+            send();
+            return false;
+        }
+
+        auto& in = inputs[now % HISTORY];
+        in[local] = localInput;
+        if (now >= confirmedRemote) in[remote] = lastRemoteInput;   // predict
+        snapshots[now % HISTORY] = current;
+        simStep(*level, current, in.data(), SIM_TICK_DT);   // no-op once the prediction has ended
+        nextTick++;
+        stepConfirmed();
+
+        send();
+        return true;
+    }
+
+    // After the match: take in late packets and resend until the peer has
+    // all of our inputs up to the confirmed end. Returns true while that is
+    // still pending.
+    bool poll() {
+        receive(nextTick);
+        stepConfirmed();
+        if (remoteAck >= confirmedTick) return false;
+        send();
+        return true;
+    }
+
+    const GameState& state() const { return current; }            // predicted, for display
+    const GameState& confirmedState() const { return confirmed; } // only confirmed inputs applied
+    bool finished() const { return confirmed.status != SimStatus::Playing; }
+    std::uint32_t tick() const { return nextTick; }
+    int localPlayer() const { return local; }
+    bool peerSeen() const { return stats.packetsIn > 0; }
+    const Stats& getStats() const { return stats; }
+
+private:
+    struct InputPacket {
+        std::uint32_t magic;
+        std::uint32_t firstTick;   // tick of inputs[0]
+        std::uint32_t ack;         // sender has our inputs for every tick before this
+        std::uint8_t count;
+        std::uint8_t inputs[SEND_WINDOW];
+    };
+
+    // Drain the socket. Returns the earliest tick whose prediction was wrong
+    // (or 'now' when none was).
+    std::uint32_t receive(std::uint32_t now) {
+        std::uint32_t rollbackFrom = now;
+        InputPacket pkt;
+        std::size_t got = 0;
+        std::optional<sf::IpAddress> from;
+        unsigned short fromPort = 0;
+
+        while (socket.receive(&pkt, sizeof(pkt), got, from, fromPort) == sf::Socket::Status::Done) {
+            const std::size_t header = offsetof(InputPacket, inputs);
+            if (got < header || pkt.magic != PACKET_MAGIC || pkt.count > SEND_WINDOW || got < header + pkt.count) continue;
+            stats.packetsIn++;
+            remoteAck = std::max(remoteAck, pkt.ack);
+
+            for (std::uint32_t i = 0; i < pkt.count; ++i) {
+                std::uint32_t t = pkt.firstTick + i;
+                if (t < confirmedRemote) continue;
+                if (t > confirmedRemote) break;   // gap: a later packet will resend it
+                if (t >= now + HISTORY - MAX_ROLLBACK) break;
+
+                std::uint8_t v = pkt.inputs[i];
+                auto& in = inputs[t % HISTORY];
+                if (t < now && in[remote] != v) rollbackFrom = std::min(rollbackFrom, t);
+                in[remote] = v;
+                lastRemoteInput = v;
+                confirmedRemote++;
+            }
+        }
+        return rollbackFrom;
+    }
+
+    void resimulate(std::uint32_t from, std::uint32_t now) {
+        auto t0 = std::chrono::steady_clock::now();
+        current = snapshots[from % HISTORY];
+        for (std::uint32_t t = from; t < now; ++t) {
+            auto& in = inputs[t % HISTORY];
+            if (t >= confirmedRemote) in[remote] = lastRemoteInput;   // re-predict with newer info
+            snapshots[t % HISTORY] = current;
+            simStep(*level, current, in.data(), SIM_TICK_DT);
+        }
+        float us = std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - t0).count();
+
+        std::uint32_t ticks = now - from;
+        stats.rollbacks++;
+        stats.resimTicks += ticks;
+        stats.maxResimTicks = std::max(stats.maxResimTicks, ticks);
+        stats.lastResimUs = us;
+        stats.maxResimUs = std::max(stats.maxResimUs, us);
+    }
+
+    // Every tick with both inputs known, up to the end of the match.
+    void stepConfirmed() {
+        const std::uint32_t known = std::min(nextTick, confirmedRemote);
+        while (confirmedTick < known && confirmed.status == SimStatus::Playing) {
+            simStep(*level, confirmed, inputs[confirmedTick % HISTORY].data(), SIM_TICK_DT);
+            confirmedTick++;
+        }
+    }
+
+    void send() {
+        const std::uint32_t end = nextTick;   // inputs exist for every tick before this
+        std::uint32_t first = std::max(remoteAck, end > SEND_WINDOW ? end - SEND_WINDOW : 0u);
+        InputPacket pkt;
+        pkt.magic = PACKET_MAGIC;
+        pkt.firstTick = first;
+        pkt.ack = confirmedRemote;
+        pkt.count = static_cast<std::uint8_t>(end - std::min(first, end));
+        for (std::uint32_t i = 0; i < pkt.count; ++i) pkt.inputs[i] = inputs[(first + i) % HISTORY][local];
+
+        std::size_t size = offsetof(InputPacket, inputs) + pkt.count;
+        if (socket.send(&pkt, size, sf::IpAddress::LocalHost, peerPort) == sf::Socket::Status::Done) stats.packetsOut++;
+    }
+
+    const SimLevel* level = nullptr;
+    int local = 0;
+    int remote = 1;
+    unsigned short peerPort = 0;
+    sf::UdpSocket socket;
+
+    GameState current{};
+    GameState confirmed{};
+    std::uint32_t nextTick = 0;        // ticks issued so far; keeps counting after 'current' ends
+    std::uint32_t confirmedTick = 0;   // ticks applied to 'confirmed'
+    std::array<GameState, HISTORY> snapshots{};                 // state before tick t
+    std::array<std::array<std::uint8_t, 2>, HISTORY> inputs{};  // inputs used for tick t
+    std::uint32_t confirmedRemote = 0;   // remote inputs known for every tick before this
+    std::uint8_t lastRemoteInput = 0;
+    std::uint32_t remoteAck = 0;
+    Stats stats;
+};
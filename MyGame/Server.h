@@ -0,0 +1,299 @@
+// Server.h
+// Headless host for many concurrent matches in one process.
+//
+// Level data that never changes during a match (LevelDef, WorldGeometry with
+// its BVH and grid, SimLevel with its target index, the bots' path graph) is
+// built once per level and shared read-only through
+// shared_ptr<const SharedLevel>. A match is
+// just a GameState, a bot controller and an input log; the log lives in a
+// per-match arena that is released in one go when the match restarts.
+// Matches are sharded across worker threads; each shard ticks its matches at
+// a fixed rate and no state is shared between shards except the counters.
+
+#pragma once
+
+#include "PathGraph.h"
+#include "Sim.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <thread>
+#include <vector>
+
+struct SharedLevel {
+    LevelDef def;
+    WorldGeometry world;
+    SimLevel sim;   // points into 'world', so SharedLevel never moves
+    PathGraph paths;   // likewise
+
+    SharedLevel(const LevelDef& L, const SimTuning& tuning) : def(L) {
+        buildLevelGeometry(def, world);
+        sim.build(def, world, tuning);
+        paths.build(world, { def.worldW, def.worldH }, tuning.playerRadius);
+    }
+
+    SharedLevel(const SharedLevel&) = delete;
+    SharedLevel& operator=(const SharedLevel&) = delete;
+};
+
+// Follows the path graph toward some live target; wanders for a moment when stuck.
+struct BotBrain {
+    static constexpr int REPLAN_TICKS = 30;
+    static constexpr float WAYPOINT_REACH = 6.f;   // px
+
+    std::uint32_t rng = 1;
+    std::uint32_t goal = 0;
+    std::uint8_t wanderInput = 0;
+    int wanderTicks = 0;
+    sf::Vector2f lastPos;
+    std::vector<sf::Vector2f> route;   // waypoints to 'routeGoal', ending at it
+    std::size_t routeStep = 0;
+    std::uint32_t routeGoal = std::numeric_limits<std::uint32_t>::max();
+    int replanTicks = 0;
+    PathGraph::Search search;
+
+    // Fresh state for a new match; the route and search keep their storage.
+    void reset(std::uint32_t seed) {
+        rng = seed;
+        goal = 0;
+        wanderInput = 0;
+        wanderTicks = 0;
+        lastPos = {};
+        route.clear();
+        routeStep = 0;
+        routeGoal = std::numeric_limits<std::uint32_t>::max();
+        replanTicks = 0;
+    }
+
+    std::uint32_t next() { rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5; return rng; }
+
+    std::uint8_t think(const SimLevel& level, const PathGraph& paths, const GameState& s, int player) {
+        const sf::Vector2f pos = s.players[player].pos;
+        bool stuck = pos == lastPos;
+        lastPos = pos;
+
+        if (wanderTicks > 0) { wanderTicks--; return wanderInput; }
+        if (stuck && (next() & 3) == 0) {
+            wanderInput = static_cast<std::uint8_t>(next() & 15);
+            wanderTicks = 20 + static_cast<int>(next() % 40);
+            replanTicks = 0;
+            return wanderInput;
+        }
+
+        std::size_t n = level.targets.size();
+        if (n == 0) return 0;
+        if (goal >= n || !s.isTargetAlive(goal)) {
+            std::size_t start = next() % n;
+            for (std::size_t k = 0; k < n; ++k) {
+                std::size_t id = (start + k) % n;
+                if (s.isTargetAlive(id)) { goal = static_cast<std::uint32_t>(id); break; }
+            }
+        }
+
+        // Replanned now and then since 8-way steering drifts off the route
+        if (goal != routeGoal || --replanTicks <= 0) {
+            const sf::Vector2f target = level.targets[goal];
+            if (!paths.findPath(pos, target, route, search)) {
+                // Targets can sit against a wall; the discs only have to touch
+                const float reach = level.tune.playerRadius + level.tune.targetRadius - 2.f;
+                for (int k = 0; k < 8; ++k) {
+                    float a = k * 0.7853982f;
+                    sf::Vector2f p = target + sf::Vector2f(std::cos(a), std::sin(a)) * reach;
+                    if (!level.world->circleBlocked(p, level.tune.playerRadius) && paths.findPath(pos, p, route, search)) break;
+                }
+            }
+            routeStep = 0;
+            routeGoal = goal;
+            replanTicks = REPLAN_TICKS;
+        }
+        while (routeStep + 1 < route.size()) {
+            sf::Vector2f w = route[routeStep] - pos;
+            if (w.x * w.x + w.y * w.y > WAYPOINT_REACH * WAYPOINT_REACH) break;
+            routeStep++;
+        }
+
+        sf::Vector2f d = route[routeStep] - pos;
+        std::uint8_t in = 0;
+        if (d.x < -4.f) in |= INPUT_LEFT;
+        if (d.x > 4.f) in |= INPUT_RIGHT;
+        if (d.y < -4.f) in |= INPUT_UP;
+        if (d.y > 4.f) in |= INPUT_DOWN;
+        return in;
+    }
+};
+
+class MatchServer {
+public:
+    static constexpr std::size_t MATCH_ARENA_BYTES = 16 * 1024;   // input log of a typical match; spills to the heap beyond
+    static constexpr int TICK_HZ = 60;
+
+    struct Config {
+        int matches = 100;
+        int threads = 0;          // 0 = hardware_concurrency
+        int players = 2;
+        float seconds = 10.f;     // wall-clock run time
+        bool unthrottled = false; // tick as fast as possible instead of at TICK_HZ
+    };
+
+    MatchServer(std::vector<std::shared_ptr<const SharedLevel>> levelSet, Config cfg)
+        : levels(std::move(levelSet)), config(cfg) {}
+
+    // Runs for config.seconds and prints a report every second plus a summary.
+    void run() {
+        unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+        int threadCount = config.threads > 0 ? config.threads : static_cast<int>(hw);
+        threadCount = std::clamp(threadCount, 1, std::max(1, config.matches));
+
+        std::vector<Shard> shards(threadCount);
+        for (int m = 0; m < config.matches; ++m) {
+            Shard& sh = shards[m % threadCount];
+            sh.matches.push_back(std::make_unique<Match>(levels[m % levels.size()], config.players, 0x9E3779B9u * (m + 1)));
+        }
+
+        std::printf("Server: %d matches (%d players each) on %d threads, %zu shared levels, %s\n",
+            config.matches, config.players, threadCount, levels.size(),
+            config.unthrottled ? "unthrottled" : "60 Hz");
+
+        std::atomic<bool> stop{ false };
+        std::vector<std::thread> pool;
+        for (auto& sh : shards) pool.emplace_back([this, &sh, &stop] { runShard(sh, stop); });
+
+        using Clock = std::chrono::steady_clock;
+        auto begin = Clock::now();
+        auto nextReport = begin + std::chrono::seconds(1);
+        Totals last{};
+        while (Clock::now() - begin < std::chrono::duration<float>(config.seconds)) {
+            std::this_thread::sleep_until(nextReport);
+            nextReport += std::chrono::seconds(1);
+            Totals now = collect(shards);
+            report(now, last, threadCount, 1.0);
+            last = now;
+        }
+        stop = true;
+        for (auto& t : pool) t.join();
+
+        Totals total = collect(shards);
+        double elapsed = std::chrono::duration<double>(Clock::now() - begin).count();
+        std::printf("---- summary over %.1f s ----\n", elapsed);
+        report(total, Totals{}, threadCount, elapsed);
+    }
+
+private:
+    struct Match {
+        std::shared_ptr<const SharedLevel> level;
+        GameState state{};
+        BotBrain bots[MAX_SIM_PLAYERS];
+        int players;
+        std::uint32_t seed;
+
+        // Per-match arena: the input log is carved from 'arena', which is
+        // rewound (not freed piecemeal) when the match restarts.
+        std::unique_ptr<std::byte[]> arenaBuffer;
+        std::pmr::monotonic_buffer_resource arena;
+        std::pmr::vector<std::uint8_t> inputLog;
+
+        Match(std::shared_ptr<const SharedLevel> lvl, int playerCount, std::uint32_t seedValue)
+            : level(std::move(lvl)), players(playerCount), seed(seedValue),
+              arenaBuffer(new std::byte[MATCH_ARENA_BYTES]),
+              arena(arenaBuffer.get(), MATCH_ARENA_BYTES),
+              inputLog(&arena) {
+            restart();
+        }
+
+        void restart() {
+            inputLog = std::pmr::vector<std::uint8_t>(&arena);   // drop the old log before rewinding
+            arena.release();
+            inputLog.reserve(MATCH_ARENA_BYTES / 2);
+            state = makeInitialState(level->sim, players);
+            seed = seed * 1664525u + 1013904223u;
+            for (int p = 0; p < players; ++p) {
+                bots[p].reset(seed ^ (0x85EBCA6Bu * (p + 1)));
+            }
+        }
+
+        void tick() {
+            std::uint8_t in[MAX_SIM_PLAYERS] = {};
+            for (int p = 0; p < players; ++p) in[p] = bots[p].think(level->sim, level->paths, state, p);
+            inputLog.insert(inputLog.end(), in, in + players);
+            simStep(level->sim, state, in, SIM_TICK_DT);
+        }
+    };
+
+    struct Shard {
+        std::vector<std::unique_ptr<Match>> matches;
+        std::atomic<std::uint64_t> ticks{ 0 };          // match-ticks
+        std::atomic<std::uint64_t> busyNs{ 0 };         // time spent ticking
+        std::atomic<std::uint64_t> finished{ 0 };
+        std::atomic<std::uint64_t> worstTickNs{ 0 };    // slowest single match tick
+    };
+
+    struct Totals {
+        std::uint64_t ticks = 0;
+        std::uint64_t busyNs = 0;
+        std::uint64_t finished = 0;
+        std::uint64_t worstTickNs = 0;
+    };
+
+    void runShard(Shard& sh, std::atomic<bool>& stop) {
+        using Clock = std::chrono::steady_clock;
+        const auto period = std::chrono::nanoseconds(1000000000 / TICK_HZ);
+        auto next = Clock::now();
+
+        while (!stop.load(std::memory_order_relaxed)) {
+            auto t0 = Clock::now();
+            std::uint64_t worst = 0;
+            std::uint64_t done = 0;
+            for (auto& m : sh.matches) {
+                auto a = Clock::now();
+                m->tick();
+                if (m->state.status != SimStatus::Playing) { m->restart(); done++; }
+                worst = std::max<std::uint64_t>(worst, std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - a).count());
+            }
+            auto busy = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count();
+
+            sh.ticks.fetch_add(sh.matches.size(), std::memory_order_relaxed);
+            sh.busyNs.fetch_add(static_cast<std::uint64_t>(busy), std::memory_order_relaxed);
+            sh.finished.fetch_add(done, std::memory_order_relaxed);
+            if (worst > sh.worstTickNs.load(std::memory_order_relaxed)) sh.worstTickNs.store(worst, std::memory_order_relaxed);
+
+            if (!config.unthrottled) {
+                next += period;
+                if (next < Clock::now()) next = Clock::now();   // overloaded: don't try to catch up
+                std::this_thread::sleep_until(next);
+            }
+        }
+    }
+
+    static Totals collect(const std::vector<Shard>& shards) {
+        Totals t;
+        for (const auto& sh : shards) {
+            t.ticks += sh.ticks.load(std::memory_order_relaxed);
+            t.busyNs += sh.busyNs.load(std::memory_order_relaxed);
+            t.finished += sh.finished.load(std::memory_order_relaxed);
+            t.worstTickNs = std::max(t.worstTickNs, sh.worstTickNs.load(std::memory_order_relaxed));
+        }
+        return t;
+    }
+
+    // Matches per core = how many matches one fully busy core could tick at
+    // 60 Hz, given the measured cost of one match tick.
+    void report(const Totals& now, const Totals& before, int threadCount, double seconds) const {
+        std::uint64_t ticks = now.ticks - before.ticks;
+        std::uint64_t busy = now.busyNs - before.busyNs;
+        double usPerMatchTick = ticks ? busy / 1000.0 / ticks : 0.0;
+        double matchesPerCore = usPerMatchTick > 0.0 ? (1e6 / TICK_HZ) / usPerMatchTick : 0.0;
+        double load = busy / 1e9 / (seconds * threadCount);
+        std::printf("ticks/s %9.0f | tick/match %7.2f us (worst %7.1f us) | matches/core %8.0f | shard load %5.1f%% | finished %llu\n",
+            ticks / seconds, usPerMatchTick, now.worstTickNs / 1000.0, matchesPerCore, 100.0 * load,
+            static_cast<unsigned long long>(now.finished - before.finished));
+    }
+
+    std::vector<std::shared_ptr<const SharedLevel>> levels;
+    Config config;
+};
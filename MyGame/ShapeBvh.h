@@ -0,0 +1,275 @@
+// ShapeBvh.h
+// Bounding volume hierarchy over mixed level shapes (rects, convex polygons,
+// circles and loose wall edges). Leaves store tagged references, so one
+// index answers both collision overlap queries and visibility ray casts.
+
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory_resource>
+#include <vector>
+
+enum class ShapeKind : std::uint8_t { Rect, Poly, Circle, Edge };
+
+struct ShapeRef {
+    ShapeKind kind;
+    std::uint16_t chunk;   // quantized edges only: chunk the coordinates are relative to
+    std::uint32_t index;   // into the matching WorldGeometry array
+};
+
+struct Aabb {
+    float minX, minY, maxX, maxY;
+
+    static Aabb empty() {
+        const float inf = std::numeric_limits<float>::infinity();
+        return { inf, inf, -inf, -inf };
+    }
+    static Aabb fromRect(const sf::FloatRect& r) {
+        return { r.position.x, r.position.y, r.position.x + r.size.x, r.position.y + r.size.y };
+    }
+    void grow(const Aabb& o) {
+        minX = std::min(minX, o.minX); minY = std::min(minY, o.minY);
+        maxX = std::max(maxX, o.maxX); maxY = std::max(maxY, o.maxY);
+    }
+    bool overlaps(const Aabb& o) const {
+        return minX <= o.maxX && o.minX <= maxX && minY <= o.maxY && o.minY <= maxY;
+    }
+    sf::Vector2f center() const { return { (minX + maxX) * 0.5f, (minY + maxY) * 0.5f }; }
+};
+
+struct BvhNode {
+    Aabb box;
+    std::uint32_t first;   // leaf: first ref; inner: index of left child (right = left + 1)
+    std::uint32_t count;   // leaf: number of refs; inner: 0
+};
+
+class ShapeBvh {
+public:
+    static constexpr std::uint32_t LEAF_SIZE = 4;
+
+    std::pmr::vector<BvhNode> nodes;
+    std::pmr::vector<ShapeRef> refs;
+    std::pmr::vector<Aabb> boxes;   // parallel to refs
+
+    ShapeBvh() = default;
+    explicit ShapeBvh(std::pmr::memory_resource* mem) : nodes(mem), refs(mem), boxes(mem) {}
+
+    // Empty, with the storage handed back to the resource.
+    void clear() {
+        std::pmr::vector<BvhNode>(nodes.get_allocator()).swap(nodes);
+        std::pmr::vector<ShapeRef>(refs.get_allocator()).swap(refs);
+        std::pmr::vector<Aabb>(boxes.get_allocator()).swap(boxes);
+    }
+    bool empty() const { return nodes.empty(); }
+
+    // Items allocated from the BVH's own resource are adopted without a copy.
+    void build(std::pmr::vector<ShapeRef> items, std::pmr::vector<Aabb> itemBoxes) {
+        refs = std::move(items);
+        boxes = std::move(itemBoxes);
+        nodes.clear();
+        if (refs.empty()) return;
+
+        nodes.reserve(2 * refs.size() - 1);   // a full binary tree over at most refs.size() leaves
+        nodes.push_back({ Aabb::empty(), 0, static_cast<std::uint32_t>(refs.size()) });
+        subdivide(0);
+    }
+
+    // Visit every ref whose box overlaps 'query'.
+    template <typename F>
+    void queryAabb(const Aabb& query, F&& visit) const {
+        if (nodes.empty()) return;
+        std::uint32_t stack[64];
+        int sp = 0;
+        stack[sp++] = 0;
+        while (sp > 0) {
+            const BvhNode& n = nodes[stack[--sp]];
+            if (!n.box.overlaps(query)) continue;
+            if (n.count > 0) {
+                for (std::uint32_t i = n.first; i < n.first + n.count; ++i) {
+                    if (boxes[i].overlaps(query)) visit(refs[i]);
+                }
+            }
+            else {
+                stack[sp++] = n.first;
+                stack[sp++] = n.first + 1;
+            }
+        }
+    }
+
+    // Closest-hit traversal. 'hit(ref, tMax, t)' tests one shape and returns true
+    // with t < tMax on a hit; subtrees further than the current best are skipped.
+    template <typename F>
+    bool raycast(sf::Vector2f origin, sf::Vector2f dir, float& tMax, F&& hit) const {
+        if (nodes.empty()) return false;
+        // A huge finite inverse (not inf) keeps axis-parallel rays free of 0 * inf NaNs.
+        sf::Vector2f inv = { dir.x != 0.f ? 1.f / dir.x : 1e30f, dir.y != 0.f ? 1.f / dir.y : 1e30f };
+        bool any = false;
+
+        std::uint32_t stack[64];
+        int sp = 0;
+        stack[sp++] = 0;
+        while (sp > 0) {
+            const BvhNode& n = nodes[stack[--sp]];
+            if (slabEntry(n.box, origin, inv, tMax) > tMax) continue;
+
+            if (n.count > 0) {
+                for (std::uint32_t i = n.first; i < n.first + n.count; ++i) {
+                    float t;
+                    if (hit(refs[i], tMax, t)) { tMax = t; any = true; }
+                }
+                continue;
+            }
+
+            // Push the farther child first so the nearer one is visited first.
+            float tl = slabEntry(nodes[n.first].box, origin, inv, tMax);
+            float tr = slabEntry(nodes[n.first + 1].box, origin, inv, tMax);
+            if (tl <= tr) { stack[sp++] = n.first + 1; stack[sp++] = n.first; }
+            else { stack[sp++] = n.first; stack[sp++] = n.first + 1; }
+        }
+        return any;
+    }
+
+    // Whether 'test(ref)' holds for any ref whose box, padded by 'pad', the
+    // segment a-b touches. Stops at the first one, so blocked lines are cheap.
+    template <typename F>
+    bool anyAlongSegment(sf::Vector2f a, sf::Vector2f b, float pad, F&& test) const {
+        if (nodes.empty()) return false;
+        sf::Vector2f d = b - a;
+        sf::Vector2f inv = { d.x != 0.f ? 1.f / d.x : 1e30f, d.y != 0.f ? 1.f / d.y : 1e30f };
+        auto touches = [&](const Aabb& box) {
+            return slabEntry({ box.minX - pad, box.minY - pad, box.maxX + pad, box.maxY + pad }, a, inv, 1.f) <= 1.f;
+            };
+
+        std::uint32_t stack[64];
+        int sp = 0;
+        stack[sp++] = 0;
+        while (sp > 0) {
+            const BvhNode& n = nodes[stack[--sp]];
+            if (!touches(n.box)) continue;
+            if (n.count > 0) {
+                for (std::uint32_t i = n.first; i < n.first + n.count; ++i) {
+                    if (touches(boxes[i]) && test(refs[i])) return true;
+                }
+            }
+            else {
+                stack[sp++] = n.first;
+                stack[sp++] = n.first + 1;
+            }
+        }
+        return false;
+    }
+
+    // Closest hits for PACKET rays from one origin (the visibility fan), sharing
+    // one traversal: a node is entered if any lane's ray reaches it, children
+    // are visited nearest-first by the packet's smallest entry, and each leaf
+    // shape is handed to 'hit(ref, tMax)', which tests it against every lane
+    // and lowers tMax[lane] where it is closer. Lanes the caller doesn't need
+    // should repeat a real ray.
+    static constexpr int PACKET = 8;
+
+    template <typename F>
+    void raycastPacket(sf::Vector2f origin, const sf::Vector2f* dirs, float* tMax, F&& hit) const {
+        if (nodes.empty()) return;
+        float invX[PACKET], invY[PACKET];
+        for (int l = 0; l < PACKET; ++l) {
+            invX[l] = dirs[l].x != 0.f ? 1.f / dirs[l].x : 1e30f;
+            invY[l] = dirs[l].y != 0.f ? 1.f / dirs[l].y : 1e30f;
+        }
+
+        std::uint32_t stack[64];
+        int sp = 0;
+        stack[sp++] = 0;
+        while (sp > 0) {
+            const BvhNode& n = nodes[stack[--sp]];
+            if (n.count > 0) {
+                if (packetEntry(n.box, origin, invX, invY, tMax) == std::numeric_limits<float>::infinity()) continue;
+                for (std::uint32_t i = n.first; i < n.first + n.count; ++i) hit(refs[i], tMax);
+                continue;
+            }
+
+            // Children are tested before pushing, so misses never reach the stack;
+            // leaves are tested again when popped, against the tighter tMax by then.
+            float tl = packetEntry(nodes[n.first].box, origin, invX, invY, tMax);
+            float tr = packetEntry(nodes[n.first + 1].box, origin, invX, invY, tMax);
+            const float inf = std::numeric_limits<float>::infinity();
+            if (tl <= tr) {
+                if (tr != inf) stack[sp++] = n.first + 1;
+                if (tl != inf) stack[sp++] = n.first;
+            }
+            else {
+                if (tl != inf) stack[sp++] = n.first;
+                if (tr != inf) stack[sp++] = n.first + 1;
+            }
+        }
+    }
+
+    // Smallest entry distance over the lanes whose ray reaches the box within
+    // its own tMax, or +inf when none does. Written lane-wise so it vectorizes.
+    static float packetEntry(const Aabb& b, sf::Vector2f o, const float* invX, const float* invY, const float* tMax) {
+        float best = std::numeric_limits<float>::infinity();
+        for (int l = 0; l < PACKET; ++l) {
+            float tx1 = (b.minX - o.x) * invX[l], tx2 = (b.maxX - o.x) * invX[l];
+            float ty1 = (b.minY - o.y) * invY[l], ty2 = (b.maxY - o.y) * invY[l];
+            float tmin = std::max(std::max(std::min(tx1, tx2), std::min(ty1, ty2)), 0.f);
+            float tmax = std::min(std::max(tx1, tx2), std::max(ty1, ty2));
+            bool in = tmax >= tmin && tmin <= tMax[l];
+            best = std::min(best, in ? tmin : std::numeric_limits<float>::infinity());
+        }
+        return best;
+    }
+
+    // Entry distance of the ray into the box, or +inf when it misses within [0, tMax].
+    static float slabEntry(const Aabb& b, sf::Vector2f o, sf::Vector2f inv, float tMax) {
+        float tx1 = (b.minX - o.x) * inv.x, tx2 = (b.maxX - o.x) * inv.x;
+        float ty1 = (b.minY - o.y) * inv.y, ty2 = (b.maxY - o.y) * inv.y;
+        float tmin = std::max(std::min(tx1, tx2), std::min(ty1, ty2));
+        float tmax = std::min(std::max(tx1, tx2), std::max(ty1, ty2));
+        tmin = std::max(tmin, 0.f);
+        if (tmax < tmin || tmin > tMax) return std::numeric_limits<float>::infinity();
+        return tmin;
+    }
+
+private:
+    // Median split on the longer axis of the centroid bounds.
+    void subdivide(std::uint32_t nodeIdx) {
+        BvhNode& node = nodes[nodeIdx];
+        Aabb box = Aabb::empty();
+        Aabb centroids = Aabb::empty();
+        for (std::uint32_t i = node.first; i < node.first + node.count; ++i) {
+            box.grow(boxes[i]);
+            sf::Vector2f c = boxes[i].center();
+            centroids.grow({ c.x, c.y, c.x, c.y });
+        }
+        node.box = box;
+        if (node.count <= LEAF_SIZE) return;
+
+        bool splitX = (centroids.maxX - centroids.minX) >= (centroids.maxY - centroids.minY);
+        std::uint32_t first = node.first;
+        std::uint32_t count = node.count;
+        std::uint32_t mid = count / 2;
+
+        std::vector<std::uint32_t> order(count);
+        for (std::uint32_t i = 0; i < count; ++i) order[i] = first + i;
+        std::nth_element(order.begin(), order.begin() + mid, order.end(), [&](std::uint32_t a, std::uint32_t b) {
+            return splitX ? boxes[a].center().x < boxes[b].center().x : boxes[a].center().y < boxes[b].center().y;
+            });
+
+        std::vector<ShapeRef> r(count);
+        std::vector<Aabb> bx(count);
+        for (std::uint32_t i = 0; i < count; ++i) { r[i] = refs[order[i]]; bx[i] = boxes[order[i]]; }
+        std::copy(r.begin(), r.end(), refs.begin() + first);
+        std::copy(bx.begin(), bx.end(), boxes.begin() + first);
+
+        std::uint32_t left = static_cast<std::uint32_t>(nodes.size());
+        nodes.push_back({ Aabb::empty(), first, mid });
+        nodes.push_back({ Aabb::empty(), first + mid, count - mid });
+        nodes[nodeIdx].first = left;
+        nodes[nodeIdx].count = 0;
+
+        subdivide(left);
+        subdivide(left + 1);
+    }
+};
@@ -0,0 +1,207 @@
+// Sim.h
+// Deterministic gameplay step over a plain-old-data GameState.
+//
+// Everything that changes during a match lives in GameState, which is a flat,
+// trivially copyable struct: a snapshot is one memcpy, which is what rollback
+// needs. Everything that does not change (geometry, target and powerup
+// positions, tuning) lives in SimLevel and is only read by simStep().
+// Presentation (sprites, decals, UI) is derived from state changes by the
+// caller and never feeds back into the simulation.
+
+#pragma once
+
+#include "Level.h"
+#include "KdTree.h"
+#include "WorldGeometry.h"
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <memory_resource>
+#include <type_traits>
+#include <vector>
+
+constexpr int MAX_SIM_PLAYERS = 2;
+constexpr int MAX_SIM_TARGETS = 1024;
+constexpr int MAX_SIM_POWERUPS = 64;
+constexpr float SIM_TICK_DT = 1.f / 60.f;   // fixed step for networked play
+
+enum InputBits : std::uint8_t {
+    INPUT_UP = 1,
+    INPUT_DOWN = 2,
+    INPUT_LEFT = 4,
+    INPUT_RIGHT = 8,
+};
+
+inline sf::Vector2f inputDirection(std::uint8_t input) {
+    sf::Vector2f dir(0.f, 0.f);
+    if (input & INPUT_UP) dir.y -= 1.f;
+    if (input & INPUT_DOWN) dir.y += 1.f;
+    if (input & INPUT_LEFT) dir.x -= 1.f;
+    if (input & INPUT_RIGHT) dir.x += 1.f;
+    return normalize(dir);
+}
+
+// The single-player game's tuning. The game, the bots and the replay
+// verifier all use these defaults, so they are the one place to change it.
+struct SimTuning {
+    float playerRadius = 22.f;
+    float targetRadius = 18.f;
+    float baseSpeed = 320.f;
+    float powerupRadius = 16.f;
+    float timeAddSeconds = 6.f;
+    float speedMult = 1.55f;
+    float speedDuration = 5.f;
+    float arrowDuration = 6.f;
+    float fullLightDuration = 5.f;
+};
+
+enum class SimStatus : std::uint8_t { Playing, Cleared, TimeUp };
+
+struct PlayerState {
+    sf::Vector2f pos;
+    float speedBoostLeft;
+    float arrowLeft;
+    float fullLightLeft;
+    std::uint16_t collected;
+};
+
+struct GameState {
+    std::uint32_t tick;
+    SimStatus status;
+    std::uint8_t playerCount;
+    std::uint16_t targetsLeft;
+    float timeLeft;
+    PlayerState players[MAX_SIM_PLAYERS];
+    std::uint64_t targetAlive[MAX_SIM_TARGETS / 64];
+    std::uint64_t powerupActive;
+
+    bool isTargetAlive(std::size_t id) const { return (targetAlive[id >> 6] >> (id & 63)) & 1u; }
+    bool isPowerupActive(std::size_t id) const { return (powerupActive >> id) & 1u; }
+};
+static_assert(std::is_trivially_copyable_v<GameState>, "GameState must stay memcpy-able for rollback");
+
+// Solid geometry of a level, without any of the drawables.
+inline void buildLevelGeometry(const LevelDef& L, WorldGeometry& world) {
+    world.clear();
+    world.rects.reserve(L.wallRects.size());
+    for (const auto& r : L.wallRects) world.rects.push_back(sf::FloatRect({ r.x, r.y }, { r.w, r.h }));
+    world.polys.assign(L.polygons.begin(), L.polygons.end());
+    world.circles.assign(L.circles.begin(), L.circles.end());
+    world.grid = buildOccupancyGrid(L.tileRows, L.tileSize);
+    world.build();
+}
+
+struct SimLevel {
+    const WorldGeometry* world = nullptr;
+    std::pmr::vector<sf::Vector2f> targets;
+    KdTree2 targetIndex;               // never modified after build; liveness is in GameState
+    std::pmr::vector<PowerUp> powerups;
+    float timeLimit = 30.f;
+    sf::Vector2f spawns[MAX_SIM_PLAYERS];
+    SimTuning tune;
+
+    SimLevel() = default;
+    explicit SimLevel(std::pmr::memory_resource* mem) : targets(mem), targetIndex(mem), powerups(mem) {}
+
+    // Empties the arrays and hands the storage back to the resource.
+    void clear() {
+        world = nullptr;
+        std::pmr::vector<sf::Vector2f>(targets.get_allocator()).swap(targets);
+        targetIndex.clear();
+        std::pmr::vector<PowerUp>(powerups.get_allocator()).swap(powerups);
+    }
+
+    // Sized once from the level, capped at what GameState can track.
+    void build(const LevelDef& L, const WorldGeometry& geometry, const SimTuning& tuning = {}) {
+        world = &geometry;
+        tune = tuning;
+        if (L.targetSpawns.size() > MAX_SIM_TARGETS) {
+            std::cout << "Level '" << L.name << "' has " << L.targetSpawns.size() << " targets; only " << MAX_SIM_TARGETS << " are simulated.\n";
+        }
+        targets.assign(L.targetSpawns.begin(), L.targetSpawns.begin() + std::min<std::size_t>(L.targetSpawns.size(), MAX_SIM_TARGETS));
+        powerups.assign(L.powerups.begin(), L.powerups.begin() + std::min<std::size_t>(L.powerups.size(), MAX_SIM_POWERUPS));
+        if (geometry.spatialOrder) {
+            sortByMorton(powerups, { 0.f, 0.f }, { L.worldW, L.worldH }, [](const PowerUp& p) { return p.pos; });
+        }
+        targetIndex.build(targets);
+        timeLimit = L.timeLimit;
+
+        // Second player starts beside the first when there is room
+        spawns[0] = L.playerSpawn;
+        spawns[1] = L.playerSpawn;
+        for (sf::Vector2f off : { sf::Vector2f(60.f, 0.f), sf::Vector2f(-60.f, 0.f), sf::Vector2f(0.f, 60.f), sf::Vector2f(0.f, -60.f) }) {
+            if (!world->circleBlocked(L.playerSpawn + off, tune.playerRadius)) { spawns[1] = L.playerSpawn + off; break; }
+        }
+    }
+};
+
+inline GameState makeInitialState(const SimLevel& level, int playerCount) {
+    GameState s{};
+    s.status = SimStatus::Playing;
+    s.playerCount = static_cast<std::uint8_t>(std::clamp(playerCount, 1, MAX_SIM_PLAYERS));
+    s.timeLeft = level.timeLimit;
+    for (int p = 0; p < s.playerCount; ++p) s.players[p].pos = level.spawns[p];
+    for (std::size_t i = 0; i < level.targets.size(); ++i) s.targetAlive[i >> 6] |= 1ull << (i & 63);
+    s.targetsLeft = static_cast<std::uint16_t>(level.targets.size());
+    s.powerupActive = level.powerups.size() >= 64 ? ~0ull : ((1ull << level.powerups.size()) - 1);
+    return s;
+}
+
+// Advance one step. inputs[p] holds InputBits for each of state.playerCount players.
+inline void simStep(const SimLevel& level, GameState& s, const std::uint8_t* inputs, float dt) {
+    if (s.status != SimStatus::Playing) return;
+    const SimTuning& t = level.tune;
+    s.tick++;
+
+    s.timeLeft -= dt;
+    if (s.timeLeft <= 0.f) {
+        s.timeLeft = 0.f;
+        s.status = SimStatus::TimeUp;
+        return;
+    }
+
+    for (int p = 0; p < s.playerCount; ++p) {
+        PlayerState& pl = s.players[p];
+        pl.speedBoostLeft = std::max(0.f, pl.speedBoostLeft - dt);
+        pl.arrowLeft = std::max(0.f, pl.arrowLeft - dt);
+        pl.fullLightLeft = std::max(0.f, pl.fullLightLeft - dt);
+
+        float speed = t.baseSpeed;
+        if (pl.speedBoostLeft > 0.f) speed *= t.speedMult;
+
+        sf::Vector2f next = pl.pos + inputDirection(inputs[p]) * speed * dt;
+        if (!level.world->circleBlocked(next, t.playerRadius)) pl.pos = next;
+
+        // Powerups
+        for (std::size_t i = 0; i < level.powerups.size(); ++i) {
+            if (!s.isPowerupActive(i)) continue;
+            const PowerUp& pw = level.powerups[i];
+            if (!circleIntersectsCircle(pl.pos, t.playerRadius, pw.pos, t.powerupRadius)) continue;
+            s.powerupActive &= ~(1ull << i);
+
+            if (pw.type == PowerType::AddTime) {
+                s.timeLeft = std::min(s.timeLeft + t.timeAddSeconds, level.timeLimit + 20.f);
+            }
+            else if (pw.type == PowerType::Speed) {
+                pl.speedBoostLeft = std::max(pl.speedBoostLeft, t.speedDuration);
+            }
+            else if (pw.type == PowerType::Arrow) {
+                pl.arrowLeft = std::max(pl.arrowLeft, t.arrowDuration);
+            }
+            else if (pw.type == PowerType::FullLight) {
+                pl.fullLightLeft = std::max(pl.fullLightLeft, t.fullLightDuration);
+            }
+        }
+
+        // Targets
+        level.targetIndex.forEachWithin(pl.pos, t.playerRadius + t.targetRadius, [&](std::uint32_t id) {
+            if (!s.isTargetAlive(id)) return;
+            if (!circleIntersectsCircle(pl.pos, t.playerRadius, level.targets[id], t.targetRadius)) return;
+            s.targetAlive[id >> 6] &= ~(1ull << (id & 63));
+            s.targetsLeft--;
+            pl.collected++;
+            });
+    }
+
+    if (s.targetsLeft == 0) s.status = SimStatus::Cleared;
+}
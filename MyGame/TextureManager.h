@@ -0,0 +1,255 @@
+// TextureManager.h
+// Budgeted texture streaming for large sprite libraries.
+//
+// Game code holds TextureHandles, never sf::Texture references, and asks
+// get() for the texture every time it binds a sprite. A texture that is not
+// resident yet (or was evicted) counts as a miss: it is queued for the
+// background decoder and a placeholder is returned until it arrives.
+// update() runs once per frame on the GL thread; it uploads finished decodes
+// and evicts least-recently-used textures until the budget is met again.
+
+#pragma once
+
+#include "ImageResample.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct TextureHandle {
+    static constexpr std::uint32_t INVALID = 0xFFFFFFFFu;
+    std::uint32_t id = INVALID;
+    bool valid() const { return id != INVALID; }
+};
+
+class TextureManager {
+public:
+    struct Stats {
+        std::size_t budgetBytes = 0;
+        std::size_t residentBytes = 0;
+        std::size_t residentCount = 0;
+        std::size_t pendingLoads = 0;
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+        std::uint64_t evictions = 0;
+        std::uint64_t failures = 0;
+    };
+
+    explicit TextureManager(std::size_t budgetBytes) {
+        stats.budgetBytes = budgetBytes;
+        sf::Image px({ 1, 1 }, sf::Color(128, 128, 128, 160));
+        if (!placeholder.loadFromImage(px)) {
+            std::cout << "Failed to create placeholder texture.\n";
+        }
+        worker = std::thread([this] { workerLoop(); });
+    }
+
+    ~TextureManager() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            quit = true;
+        }
+        cv.notify_all();
+        if (worker.joinable()) worker.join();
+    }
+
+    TextureManager(const TextureManager&) = delete;
+    TextureManager& operator=(const TextureManager&) = delete;
+
+    // Register a texture source; nothing is loaded yet. 'size' of {0, 0} keeps
+    // the file's own resolution, otherwise the image is resampled to it.
+    TextureHandle request(const std::string& path, sf::Vector2u size = { 0, 0 }) {
+        std::string key = path + "@" + std::to_string(size.x) + "x" + std::to_string(size.y);
+        auto it = byKey.find(key);
+        if (it != byKey.end()) return { it->second };
+
+        std::uint32_t id = static_cast<std::uint32_t>(entries.size());
+        entries.push_back(std::make_unique<Entry>());
+        entries.back()->job = { path, size };
+        byKey.emplace(std::move(key), id);
+        return { id };
+    }
+
+    // Start loading without waiting for a draw to ask for it.
+    void prefetch(TextureHandle h) {
+        if (!h.valid() || h.id >= entries.size()) return;
+        Entry& e = *entries[h.id];
+        if (e.state == State::Unloaded) enqueue(h.id);
+    }
+
+    // The texture for this frame: the real one when resident, otherwise the
+    // placeholder (and a load is queued). Marks the texture as used.
+    const sf::Texture& get(TextureHandle h) {
+        if (!h.valid() || h.id >= entries.size()) return placeholder;
+        Entry& e = *entries[h.id];
+        e.lastUsedFrame = frame;
+
+        if (e.state == State::Resident) {
+            stats.hits++;
+            lru.splice(lru.begin(), lru, e.lruPos);
+            return *e.texture;
+        }
+        stats.misses++;
+        if (e.state == State::Unloaded) enqueue(h.id);
+        return placeholder;
+    }
+
+    bool isResident(TextureHandle h) const { return h.valid() && h.id < entries.size() && entries[h.id]->state == State::Resident; }
+    bool isFailed(TextureHandle h) const { return !h.valid() || h.id >= entries.size() || entries[h.id]->state == State::Failed; }
+
+    // Source file behind a handle (empty for an invalid one), for messages.
+    const std::string& path(TextureHandle h) const {
+        static const std::string none;
+        return h.valid() && h.id < entries.size() ? entries[h.id]->job.path : none;
+    }
+
+    // Once per frame on the GL thread.
+    void update() {
+        frame++;
+
+        std::deque<Decoded> ready;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            ready.swap(done);
+        }
+        for (auto& d : ready) upload(d);
+
+        evictToBudget();
+    }
+
+    // Block until every queued load has been uploaded (loading screens, startup).
+    void finishPending() {
+        while (stats.pendingLoads > 0) {
+            std::deque<Decoded> ready;
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                doneCv.wait(lock, [&] { return !done.empty(); });
+                ready.swap(done);
+            }
+            for (auto& d : ready) upload(d);
+        }
+        evictToBudget();
+    }
+
+    const Stats& getStats() const { return stats; }
+
+private:
+    enum class State : std::uint8_t { Unloaded, Loading, Resident, Failed };
+
+    struct Entry {
+        ResampleJob job;
+        State state = State::Unloaded;
+        std::unique_ptr<sf::Texture> texture;
+        std::size_t bytes = 0;
+        std::uint64_t lastUsedFrame = 0;
+        std::list<std::uint32_t>::iterator lruPos;
+    };
+
+    struct Decoded {
+        std::uint32_t id;
+        ResampledImage image;
+    };
+
+    void enqueue(std::uint32_t id) {
+        Entry& e = *entries[id];
+        e.state = State::Loading;
+        stats.pendingLoads++;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            jobs.push_back({ id, e.job });
+        }
+        cv.notify_one();
+    }
+
+    void upload(Decoded& d) {
+        Entry& e = *entries[d.id];
+        stats.pendingLoads--;
+
+        auto tex = std::make_unique<sf::Texture>();
+        if (!uploadResampled(*tex, d.image)) {
+            std::cout << "Failed to load texture: " << d.image.path << "\n";
+            e.state = State::Failed;
+            stats.failures++;
+            return;
+        }
+
+        sf::Vector2u sz = tex->getSize();
+        e.bytes = static_cast<std::size_t>(sz.x) * sz.y * 4 * 4 / 3;   // + mip chain
+        e.texture = std::move(tex);
+        e.state = State::Resident;
+        lru.push_front(d.id);
+        e.lruPos = lru.begin();
+        stats.residentBytes += e.bytes;
+        stats.residentCount++;
+    }
+
+    // Oldest first; anything used this frame stays (a sprite may be bound to it).
+    void evictToBudget() {
+        while (stats.residentBytes > stats.budgetBytes && !lru.empty()) {
+            std::uint32_t id = lru.back();
+            Entry& e = *entries[id];
+            if (e.lastUsedFrame >= frame) break;
+
+            lru.pop_back();
+            e.texture.reset();
+            e.state = State::Unloaded;
+            stats.residentBytes -= e.bytes;
+            stats.residentCount--;
+            stats.evictions++;
+            e.bytes = 0;
+        }
+    }
+
+    void workerLoop() {
+        while (true) {
+            std::pair<std::uint32_t, ResampleJob> job;
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                cv.wait(lock, [&] { return quit || !jobs.empty(); });
+                if (quit) return;
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+
+            Decoded d;
+            d.id = job.first;
+            d.image.path = job.second.path;
+            sf::Image img;
+            if (img.loadFromFile(job.second.path)) {
+                sf::Vector2u size = job.second.size;
+                d.image.image = (size.x == 0 || size.y == 0) ? img : resampleImage(img, size);
+                d.image.ok = true;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                done.push_back(std::move(d));
+            }
+            doneCv.notify_all();
+        }
+    }
+
+    // Main-thread state
+    std::vector<std::unique_ptr<Entry>> entries;
+    std::unordered_map<std::string, std::uint32_t> byKey;
+    std::list<std::uint32_t> lru;   // front = most recently used
+    std::uint64_t frame = 1;
+    sf::Texture placeholder;
+    Stats stats;
+
+    // Shared with the decoder thread
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::condition_variable doneCv;
+    std::deque<std::pair<std::uint32_t, ResampleJob>> jobs;
+    std::deque<Decoded> done;
+    bool quit = false;
+    std::thread worker;
+};
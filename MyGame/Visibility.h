@@ -0,0 +1,688 @@
+// Visibility.h
+// Wall-occluded 360-degree visibility polygon around a light.
+//
+// computeVisibilityPolygon() casts a ray just before, at and just after every
+// wall corner in range, a few per round obstacle and a fixed ring, and
+// returns the hit points in angle order.
+//
+// KineticVisibility returns the same rays for a light that moves a little
+// each frame; the hit points agree up to float rounding of the hit distance.
+// Every ray direction and every critical direction (wall corners, points
+// where two occluders cross, circle tangents) sits in one cyclic angular
+// order, and each ray remembers the occluder it hit. What a ray sees
+// can only change when one of those directions passes it, i.e. when two
+// neighbours in the order swap. Each adjacent pair holds a certificate: how
+// far the light can move before the two could possibly swap, from their
+// angular gap and how fast each direction can turn. Certificates wait in a
+// queue keyed on the distance the light has travelled, so a frame looks only
+// at the pairs that came due, swaps the ones that flipped, certifies the new
+// neighbours and sends only the rays in a swap back through the BVH. Pairs
+// from one source (the rays at one corner, the rays of one circle) never swap
+// and hold no certificate. Writing the polygon out is still one pass over the
+// rays, since every vertex moves with the light; each ray re-intersects the
+// one occluder it already knows.
+// The order is built over the occluders within maxDist + 2 * SLACK, which
+// are all that can matter while the origin stays within SLACK of where it was
+// built. Drifting further, crossing a wall or entering a circle rebuilds it.
+
+#pragma once
+
+#include "Geometry.h"
+#include "WorldGeometry.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+constexpr int VISIBILITY_ARC_SAMPLES = 64;
+constexpr int VISIBILITY_CIRCLE_SAMPLES = 8;
+constexpr float VISIBILITY_PI = 3.14159265f;
+constexpr float VISIBILITY_EPS = 0.0007f;   // rad either side of a corner
+
+inline std::vector<sf::Vector2f> computeVisibilityPolygon(
+    const sf::Vector2f& origin,
+    const WorldGeometry& world,
+    float maxDist
+) {
+    // Only occluders within range cast rays, so a fixed ring of samples keeps
+    // the edge of the light round where no wall corners are nearby.
+    const int ARC_SAMPLES = VISIBILITY_ARC_SAMPLES;
+    const int CIRCLE_SAMPLES = VISIBILITY_CIRCLE_SAMPLES;
+    const float PI = VISIBILITY_PI;
+    const float eps = VISIBILITY_EPS;
+    const float NO_STOP = std::numeric_limits<float>::max();
+
+    // A ray aimed straight at a corner stops there. Whether the cast grazes
+    // the corner's own edges or slips past is down to float rounding (and
+    // to which rays share its packet), so it is not left to the cast.
+    struct Ray {
+        float angle;
+        float stop;
+    };
+    std::vector<Ray> rays;
+    rays.reserve(ARC_SAMPLES + 256);
+
+    auto addAnglesForPoint = [&](const sf::Vector2f& pt) {
+        sf::Vector2f v = pt - origin;
+        float a = std::atan2(v.y, v.x);
+        rays.push_back({ a - eps, NO_STOP });
+        rays.push_back({ a, std::sqrt(v.x * v.x + v.y * v.y) });
+        rays.push_back({ a + eps, NO_STOP });
+        };
+
+    // Round obstacles have no corners: cast just inside and outside both
+    // tangent rays, plus a few rays across the lit face to follow the curve.
+    auto addAnglesForCircle = [&](const CircleObstacle& c) {
+        sf::Vector2f d = c.c - origin;
+        float dist = std::sqrt(d.x * d.x + d.y * d.y);
+        if (dist <= c.r) return;
+
+        float mid = std::atan2(d.y, d.x);
+        float half = std::asin(c.r / dist);
+        rays.push_back({ mid - half - eps, NO_STOP });
+        rays.push_back({ mid + half + eps, NO_STOP });
+        for (int k = 0; k <= CIRCLE_SAMPLES; ++k) {
+            float s = -1.f + 2.f * static_cast<float>(k) / CIRCLE_SAMPLES;
+            rays.push_back({ mid + s * (half - eps), NO_STOP });
+        }
+        };
+
+    for (int i = 0; i < ARC_SAMPLES; ++i) {
+        rays.push_back({ -PI + 2.f * PI * static_cast<float>(i) / ARC_SAMPLES, NO_STOP });
+    }
+    world.forEachOccluderNear(origin, maxDist,
+        [&](const Segment& s) { addAnglesForPoint(s.a); addAnglesForPoint(s.b); },
+        addAnglesForCircle);
+
+    // Sorted first, so each packet of neighbouring rays walks the BVH together
+    std::sort(rays.begin(), rays.end(), [](const Ray& l, const Ray& r) { return l.angle < r.angle; });
+
+    std::vector<sf::Vector2f> dirs(rays.size());
+    std::vector<float> dist(rays.size());
+    for (std::size_t i = 0; i < rays.size(); ++i) dirs[i] = { std::cos(rays[i].angle), std::sin(rays[i].angle) };
+    world.raycastPacket(origin, dirs.data(), dirs.size(), maxDist, dist.data());
+
+    std::vector<sf::Vector2f> poly;
+    poly.reserve(rays.size());
+    for (std::size_t i = 0; i < rays.size(); ++i) {
+        float t = std::min(dist[i], rays[i].stop);
+        poly.push_back({ origin.x + dirs[i].x * t, origin.y + dirs[i].y * t });
+    }
+    return poly;
+}
+
+class KineticVisibility {
+public:
+    static constexpr float SLACK = 48.f;   // px the origin may drift from where the order was built
+
+    struct Stats {
+        std::uint32_t elements = 0;     // rays and critical directions in the order
+        std::uint32_t rays = 0;         // rays in this frame's polygon
+        std::uint32_t checked = 0;      // certificates that came due this frame
+        std::uint32_t swaps = 0;        // order events this frame
+        std::uint32_t retraced = 0;     // rays that went through the BVH this frame
+        bool rebuilt = false;
+        std::uint64_t frames = 0;
+        std::uint64_t rebuilds = 0;
+        std::uint64_t totalChecked = 0;
+        std::uint64_t totalSwaps = 0;
+        std::uint64_t totalRetraced = 0;
+        std::uint64_t totalRays = 0;
+    };
+
+    // Forget the cached order (level changed or geometry rebuilt).
+    void reset() { world = nullptr; }
+    const Stats& stats() const { return st; }
+
+    // computeVisibilityPolygon(origin, w, maxDist), ray for ray.
+    const std::vector<sf::Vector2f>& update(const WorldGeometry& w, sf::Vector2f origin, float maxDist) {
+        st.frames++;
+        st.checked = 0;
+        st.swaps = 0;
+        st.retraced = 0;
+        st.rebuilt = false;
+
+        sf::Vector2f drift = origin - buildOrigin;
+        bool keep = world == &w && range == maxDist
+            && drift.x * drift.x + drift.y * drift.y <= SLACK * SLACK
+            && !crossesOccluder(origin)
+            && advance(origin);
+        if (!keep && !build(w, origin, maxDist)) {
+            // Origin inside a circle: rare enough to just take the full path
+            world = nullptr;
+            poly = computeVisibilityPolygon(origin, w, maxDist);
+            return poly;
+        }
+        lastOrigin = origin;
+        emit(origin);
+        st.totalChecked += st.checked;
+        st.totalSwaps += st.swaps;
+        st.totalRetraced += st.retraced;
+        st.totalRays += st.rays;
+        return poly;
+    }
+
+private:
+    enum Kind : std::uint8_t { POINT_RAY, ARC_RAY, CIRCLE_RAY, CROSSING, TANGENT };
+
+    struct Element {
+        Kind kind;
+        std::int8_t sub;        // POINT_RAY: -1, 0, +1 eps; CIRCLE_RAY: 0..CIRCLE_SAMPLES + 2; TANGENT: -1, +1
+        bool dirty = true;      // front unknown, trace before use
+        bool hasFront = false;  // false: no candidate occluder along the ray at all
+        std::uint32_t id;       // point, crossing, circle or arc sample
+        ShapeRef front{};
+        float angle = 0.f;      // ARC_RAY
+        sf::Vector2f key{};     // ARC_RAY direction
+    };
+
+    struct EdgeInfo {
+        ShapeRef ref;
+        Segment s;
+        Aabb box;
+        std::uint32_t a, b;     // point ids
+    };
+
+    struct CircleInfo {
+        CircleObstacle c;
+        Aabb box;
+        float mid = 0.f, half = 0.f;   // this frame, when lit
+        bool lit = false;
+    };
+
+    struct RayOut {
+        float angle;
+        sf::Vector2f p;
+    };
+
+    // Pair (order[pos], order[pos + 1]) can't have swapped before the light
+    // has travelled 'at'. Stale once certVersion[pos] moved on.
+    struct Cert {
+        double at;
+        std::uint32_t pos;
+        std::uint32_t version;
+        bool operator>(const Cert& o) const { return at > o.at; }
+    };
+
+    // How far the light may move from here before an element's direction is
+    // past 'cap', and how fast (rad per px) the direction turns until then.
+    struct Reach {
+        float cap;
+        float rate;
+    };
+
+    // ---------------- Build ----------------
+    bool build(const WorldGeometry& w, sf::Vector2f origin, float maxDist) {
+        world = &w;
+        range = maxDist;
+        buildOrigin = origin;
+        lastOrigin = origin;
+        st.rebuilt = true;
+        st.rebuilds++;
+
+        if (++stamp == 0) {
+            std::fill(edgeStamp.begin(), edgeStamp.end(), 0u);
+            std::fill(circleStamp.begin(), circleStamp.end(), 0u);
+            stamp = 1;
+        }
+        edgeStamp.resize(w.edgeCount(), 0u);
+        circleStamp.resize(w.circles.size(), 0u);
+        edges.clear();
+        circles.clear();
+        candidateBox = Aabb::empty();
+
+        const float reach = maxDist + 2.f * SLACK;
+        bool inside = false;
+        w.bvh.queryAabb({ origin.x - reach, origin.y - reach, origin.x + reach, origin.y + reach }, [&](ShapeRef ref) {
+            if (ref.kind == ShapeKind::Edge) {
+                edgeStamp[ref.index] = stamp;
+                Segment s = w.edgeSegment(ref);
+                edges.push_back({ ref, s, { std::min(s.a.x, s.b.x), std::min(s.a.y, s.b.y), std::max(s.a.x, s.b.x), std::max(s.a.y, s.b.y) }, 0, 0 });
+                candidateBox.grow(edges.back().box);
+            }
+            else if (ref.kind == ShapeKind::Circle) {
+                circleStamp[ref.index] = stamp;
+                const CircleObstacle& c = w.circles[ref.index];
+                sf::Vector2f d = c.c - origin;
+                inside = inside || d.x * d.x + d.y * d.y <= c.r * c.r;
+                circles.push_back({ c, { c.c.x - c.r, c.c.y - c.r, c.c.x + c.r, c.c.y + c.r } });
+                candidateBox.grow(circles.back().box);
+            }
+            });
+        if (inside) return false;
+
+        // Shared corners become one point, so no two points ever tie
+        std::vector<std::pair<sf::Vector2f, std::uint32_t>> ends;
+        ends.reserve(edges.size() * 2);
+        for (std::uint32_t k = 0; k < edges.size(); ++k) {
+            ends.push_back({ edges[k].s.a, 2 * k });
+            ends.push_back({ edges[k].s.b, 2 * k + 1 });
+        }
+        std::sort(ends.begin(), ends.end(), [](const auto& l, const auto& r) {
+            return l.first.x != r.first.x ? l.first.x < r.first.x : l.first.y < r.first.y;
+            });
+        points.clear();
+        for (const auto& [p, slot] : ends) {
+            if (points.empty() || points.back() != p) points.push_back(p);
+            std::uint32_t id = static_cast<std::uint32_t>(points.size() - 1);
+            if (slot & 1) edges[slot / 2].b = id;
+            else edges[slot / 2].a = id;
+        }
+        pointUses.assign(points.size(), 0);
+        pointAngle.assign(points.size(), 0.f);
+
+        findCrossings();
+
+        elems.clear();
+        for (std::uint32_t i = 0; i < points.size(); ++i) {
+            for (std::int8_t sub = -1; sub <= 1; ++sub) elems.push_back({ POINT_RAY, sub, true, false, i });
+        }
+        for (std::uint32_t i = 0; i < crossings.size(); ++i) elems.push_back({ CROSSING, 0, true, false, i });
+        for (std::uint32_t k = 0; k < circles.size(); ++k) {
+            elems.push_back({ TANGENT, -1, true, false, k });
+            elems.push_back({ TANGENT, 1, true, false, k });
+            for (int sub = 0; sub <= VISIBILITY_CIRCLE_SAMPLES + 2; ++sub) {
+                elems.push_back({ CIRCLE_RAY, static_cast<std::int8_t>(sub), true, false, k });
+            }
+        }
+        for (int i = 0; i < VISIBILITY_ARC_SAMPLES; ++i) {
+            Element e{ ARC_RAY, 0, true, false, static_cast<std::uint32_t>(i) };
+            e.angle = -VISIBILITY_PI + 2.f * VISIBILITY_PI * static_cast<float>(i) / VISIBILITY_ARC_SAMPLES;
+            e.key = { std::cos(e.angle), std::sin(e.angle) };
+            elems.push_back(e);
+        }
+        st.elements = static_cast<std::uint32_t>(elems.size());
+
+        const std::uint32_t n = static_cast<std::uint32_t>(elems.size());
+        order.resize(n);
+        std::iota(order.begin(), order.end(), 0u);
+        std::vector<float> sortKey(n);
+        for (std::uint32_t i = 0; i < n; ++i) {
+            sf::Vector2f k = keyAt(elems[i], origin);
+            sortKey[i] = std::atan2(k.y, k.x);
+        }
+        std::sort(order.begin(), order.end(), [&](std::uint32_t l, std::uint32_t r) { return sortKey[l] < sortKey[r]; });
+
+        // Certify every pair, settling float ties the way the checks see them
+        travel = 0.0;
+        due.clear();
+        work.clear();
+        certVersion.assign(n, 0u);
+        queued.assign(n, 0);
+        for (std::uint32_t i = 0; i < n; ++i) enqueue(i);
+        if (!settle(origin)) return false;
+        st.checked = 0;
+        st.swaps = 0;
+        return true;
+    }
+
+    // Points where two occluders cross: the nearer of the two flips there.
+    // Parallel edges are skipped; where collinear edges overlap they are
+    // equally near, so either one is a correct front. Only pairs whose boxes
+    // overlap can cross, so a sweep along x finds them without trying every
+    // pair.
+    void findCrossings() {
+        crossings.clear();
+        auto add = [&](sf::Vector2f p, const sf::Vector2f* ends, int count) {
+            for (int i = 0; i < count; ++i) {
+                sf::Vector2f d = p - ends[i];
+                if (d.x * d.x + d.y * d.y < 1e-6f) return;   // already a corner
+            }
+            crossings.push_back(p);
+            };
+        auto edgeEdge = [&](const EdgeInfo& e, const EdgeInfo& f) {
+            if (e.a == f.a || e.a == f.b || e.b == f.a || e.b == f.b) return;
+            sf::Vector2f r = e.s.b - e.s.a, s = f.s.b - f.s.a;
+            float den = cross2(r, s);
+            if (std::fabs(den) < 1e-6f) return;
+            sf::Vector2f qp = f.s.a - e.s.a;
+            float t = cross2(qp, s) / den, u = cross2(qp, r) / den;
+            if (t <= 0.f || t >= 1.f || u <= 0.f || u >= 1.f) return;
+            const sf::Vector2f ends[4] = { e.s.a, e.s.b, f.s.a, f.s.b };
+            add(e.s.a + r * t, ends, 4);
+            };
+        auto edgeCircle = [&](const EdgeInfo& e, const CircleObstacle& c) {
+            sf::Vector2f d = e.s.b - e.s.a, f = e.s.a - c.c;
+            float A = d.x * d.x + d.y * d.y;
+            float B = 2.f * (f.x * d.x + f.y * d.y);
+            float C = f.x * f.x + f.y * f.y - c.r * c.r;
+            float disc = B * B - 4.f * A * C;
+            if (A == 0.f || disc <= 0.f) return;
+            float sq = std::sqrt(disc);
+            const sf::Vector2f ends[2] = { e.s.a, e.s.b };
+            for (float t : { (-B - sq) / (2.f * A), (-B + sq) / (2.f * A) }) {
+                if (t > 0.f && t < 1.f) add(e.s.a + d * t, ends, 2);
+            }
+            };
+        auto circleCircle = [&](const CircleObstacle& c, const CircleObstacle& o) {
+            sf::Vector2f d = o.c - c.c;
+            float dist = std::sqrt(d.x * d.x + d.y * d.y);
+            if (dist == 0.f || dist >= c.r + o.r || dist <= std::fabs(c.r - o.r)) return;
+            float a = (c.r * c.r - o.r * o.r + dist * dist) / (2.f * dist);
+            float h = std::sqrt(std::max(0.f, c.r * c.r - a * a));
+            sf::Vector2f base = c.c + d * (a / dist);
+            sf::Vector2f perp(-d.y / dist, d.x / dist);
+            crossings.push_back(base + perp * h);
+            crossings.push_back(base - perp * h);
+            };
+
+        // Edges are ids [0, edges), circles [edges, edges + circles)
+        const std::uint32_t edgeCount = static_cast<std::uint32_t>(edges.size());
+        auto box = [&](std::uint32_t id) -> const Aabb& { return id < edgeCount ? edges[id].box : circles[id - edgeCount].box; };
+        sweep.resize(edges.size() + circles.size());
+        std::iota(sweep.begin(), sweep.end(), 0u);
+        std::sort(sweep.begin(), sweep.end(), [&](std::uint32_t l, std::uint32_t r) { return box(l).minX < box(r).minX; });
+
+        for (std::size_t i = 0; i < sweep.size(); ++i) {
+            const std::uint32_t p = sweep[i];
+            const Aabb& pb = box(p);
+            for (std::size_t j = i + 1; j < sweep.size() && box(sweep[j]).minX <= pb.maxX; ++j) {
+                const std::uint32_t q = sweep[j];
+                if (!pb.overlaps(box(q))) continue;
+                const std::uint32_t lo = std::min(p, q), hi = std::max(p, q);
+                if (hi < edgeCount) edgeEdge(edges[lo], edges[hi]);
+                else if (lo < edgeCount) edgeCircle(edges[lo], circles[hi - edgeCount].c);
+                else circleCircle(circles[lo - edgeCount].c, circles[hi - edgeCount].c);
+            }
+        }
+    }
+
+    // ---------------- Certificates ----------------
+    static float circleRayAngle(const CircleInfo& ci, int sub) {
+        const float eps = VISIBILITY_EPS;
+        if (sub == 0) return ci.mid - ci.half - eps;
+        if (sub == 1) return ci.mid + ci.half + eps;
+        float s = -1.f + 2.f * static_cast<float>(sub - 2) / VISIBILITY_CIRCLE_SAMPLES;
+        return ci.mid + s * (ci.half - eps);
+    }
+
+    // Direction of an element from 'origin'; any length. Corners, crossings
+    // and tangents need no trig.
+    sf::Vector2f keyAt(const Element& e, sf::Vector2f origin) const {
+        static const float COS_EPS = std::cos(VISIBILITY_EPS);
+        static const float SIN_EPS = std::sin(VISIBILITY_EPS);
+        switch (e.kind) {
+        case POINT_RAY: {
+            sf::Vector2f v = points[e.id] - origin;
+            if (e.sub == 0) return v;
+            return { v.x * COS_EPS - e.sub * v.y * SIN_EPS, v.y * COS_EPS + e.sub * v.x * SIN_EPS };
+        }
+        case CROSSING:
+            return crossings[e.id] - origin;
+        case TANGENT: {
+            const CircleObstacle& c = circles[e.id].c;
+            sf::Vector2f d = c.c - origin;
+            float s = c.r / std::sqrt(d.x * d.x + d.y * d.y);
+            float co = std::sqrt(std::max(0.f, 1.f - s * s));
+            return { d.x * co - e.sub * d.y * s, d.y * co + e.sub * d.x * s };
+        }
+        case CIRCLE_RAY: {
+            CircleInfo ci = circles[e.id];
+            sf::Vector2f d = ci.c.c - origin;
+            ci.mid = std::atan2(d.y, d.x);
+            ci.half = std::asin(ci.c.r / std::sqrt(d.x * d.x + d.y * d.y));
+            float a = circleRayAngle(ci, e.sub);
+            return { std::cos(a), std::sin(a) };
+        }
+        case ARC_RAY:
+            break;
+        }
+        return e.key;
+    }
+
+    // Moving the light by delta turns the direction to a point at distance d
+    // by at most asin(delta / d), under 2 * delta / d while delta <= d / 2.
+    // A circle's rays sit at mid + s * half, |s| <= 1: mid turns like a point,
+    // and half = asin(r / d) changes at most r / (d sqrt(d^2 - r^2)) per px,
+    // worst at the nearest the centre can come, dm.
+    Reach reachOf(const Element& e, sf::Vector2f origin) const {
+        switch (e.kind) {
+        case POINT_RAY:
+        case CROSSING: {
+            sf::Vector2f v = (e.kind == POINT_RAY ? points[e.id] : crossings[e.id]) - origin;
+            float d = std::sqrt(v.x * v.x + v.y * v.y);
+            return { 0.5f * d, 2.f / std::max(d, 1e-6f) };
+        }
+        case TANGENT:
+        case CIRCLE_RAY: {
+            const CircleObstacle& c = circles[e.id].c;
+            sf::Vector2f v = c.c - origin;
+            float d = std::sqrt(v.x * v.x + v.y * v.y);
+            float cap = 0.5f * (d - c.r);
+            float dm = std::max(d - cap, c.r * 1.0001f);
+            return { cap, 2.f / d + c.r / (dm * std::sqrt(dm * dm - c.r * c.r)) };
+        }
+        case ARC_RAY:
+            break;
+        }
+        return { std::numeric_limits<float>::max(), 0.f };
+    }
+
+    // The rays at one corner, the rays of one circle and the fixed ring keep
+    // their relative order for good.
+    static bool sameSource(const Element& a, const Element& b) {
+        auto isCircle = [](const Element& e) { return e.kind == TANGENT || e.kind == CIRCLE_RAY; };
+        if (a.kind == ARC_RAY && b.kind == ARC_RAY) return true;
+        if (a.kind == POINT_RAY && b.kind == POINT_RAY) return a.id == b.id;
+        return isCircle(a) && isCircle(b) && a.id == b.id;
+    }
+
+    void enqueue(std::uint32_t pos) {
+        if (queued[pos]) return;
+        queued[pos] = 1;
+        work.push_back(pos);
+    }
+
+    // Next certificate for the pair at 'pos', which holds at 'origin'.
+    void certify(std::uint32_t pos, const Element& a, sf::Vector2f ka, const Element& b, sf::Vector2f kb, sf::Vector2f origin) {
+        certVersion[pos]++;
+        if (sameSource(a, b)) return;
+        float gap = std::atan2(cross2(ka, kb), ka.x * kb.x + ka.y * kb.y);
+        Reach ra = reachOf(a, origin), rb = reachOf(b, origin);
+        float slack = std::min({ ra.cap, rb.cap, gap / std::max(ra.rate + rb.rate, 1e-12f) });
+        due.push_back({ travel + 0.9 * std::max(slack, 0.f), pos, certVersion[pos] });
+        std::push_heap(due.begin(), due.end(), std::greater<Cert>());
+    }
+
+    // ---------------- Per frame ----------------
+    // Queue the certificates the distance travelled has used up, then settle.
+    bool advance(sf::Vector2f origin) {
+        sf::Vector2f step = origin - lastOrigin;
+        travel += std::sqrt(step.x * step.x + step.y * step.y);
+        while (!due.empty() && due.front().at <= travel) {
+            std::pop_heap(due.begin(), due.end(), std::greater<Cert>());
+            Cert c = due.back();
+            due.pop_back();
+            if (c.version == certVersion[c.pos]) enqueue(c.pos);
+        }
+        return settle(origin);
+    }
+
+    // Check the queued pairs: a pair that flipped is swapped (one event, both
+    // rays dirty) and it and both neighbours are checked again; the rest get
+    // a new certificate. False if the swaps run away (a jump too big to repair
+    // locally), which asks for a rebuild.
+    bool settle(sf::Vector2f origin) {
+        const std::uint32_t n = static_cast<std::uint32_t>(order.size());
+        const std::uint32_t cap = 4 * n + 64;
+        while (!work.empty()) {
+            const std::uint32_t i = work.back();
+            work.pop_back();
+            queued[i] = 0;
+            const std::uint32_t j = (i + 1) % n;
+            Element& a = elems[order[i]];
+            Element& b = elems[order[j]];
+            st.checked++;
+            sf::Vector2f ka = keyAt(a, origin), kb = keyAt(b, origin);
+            if (cross2(ka, kb) >= 0.f) {
+                certify(i, a, ka, b, kb, origin);
+                continue;
+            }
+            std::swap(order[i], order[j]);
+            a.dirty = true;
+            b.dirty = true;
+            if (++st.swaps > cap) return false;
+            enqueue((i + n - 1) % n);
+            enqueue(i);
+            enqueue(j);
+        }
+        return true;
+    }
+
+    // Moving through a wall flips which side of it is lit without any
+    // corner changing order, so that is a rebuild as well; so is stepping
+    // into a circle, whose rays are then undefined.
+    bool crossesOccluder(sf::Vector2f to) const {
+        sf::Vector2f from = lastOrigin;
+        if (from == to) return false;
+        bool crossed = false;
+        world->bvh.queryAabb({ std::min(from.x, to.x), std::min(from.y, to.y), std::max(from.x, to.x), std::max(from.y, to.y) }, [&](ShapeRef ref) {
+            if (crossed) return;
+            if (ref.kind == ShapeKind::Circle) {
+                const CircleObstacle& c = world->circles[ref.index];
+                sf::Vector2f d = to - c.c;
+                crossed = d.x * d.x + d.y * d.y <= c.r * c.r;
+                return;
+            }
+            if (ref.kind != ShapeKind::Edge) return;
+            Segment s = world->edgeSegment(ref);
+            float d1 = cross2(to - from, s.a - from), d2 = cross2(to - from, s.b - from);
+            float d3 = cross2(s.b - s.a, from - s.a), d4 = cross2(s.b - s.a, to - s.a);
+            crossed = d1 * d2 <= 0.f && d3 * d4 <= 0.f;
+            });
+        return crossed;
+    }
+
+    bool isCandidate(ShapeRef ref) const {
+        if (ref.kind == ShapeKind::Edge) return edgeStamp[ref.index] == stamp;
+        if (ref.kind == ShapeKind::Circle) return circleStamp[ref.index] == stamp;
+        return false;
+    }
+
+    // Nearest candidate occluder at any distance; only candidates, since the
+    // order knows nothing about the rest. Every candidate lies inside
+    // 'candidateBox', so the walk stops where the ray leaves it.
+    float trace(Element& e, sf::Vector2f origin, sf::Vector2f dir) {
+        st.retraced++;
+        e.dirty = false;
+        e.hasFront = false;
+        float tx = dir.x > 0.f ? (candidateBox.maxX - origin.x) / dir.x : dir.x < 0.f ? (candidateBox.minX - origin.x) / dir.x : std::numeric_limits<float>::max();
+        float ty = dir.y > 0.f ? (candidateBox.maxY - origin.y) / dir.y : dir.y < 0.f ? (candidateBox.minY - origin.y) / dir.y : std::numeric_limits<float>::max();
+        float best = std::min(tx, ty);
+        if (!(best >= 0.f)) return std::numeric_limits<float>::max();
+        best += 1.f;
+        e.hasFront = world->bvh.raycast(origin, dir, best, [&](ShapeRef ref, float tMax, float& t) {
+            if (!isCandidate(ref) || !world->rayHitsShape(ref, origin, dir, t) || t >= tMax) return false;
+            e.front = ref;
+            return true;
+            });
+        return e.hasFront ? best : std::numeric_limits<float>::max();
+    }
+
+    float hitDistance(Element& e, sf::Vector2f origin, sf::Vector2f dir) {
+        if (!e.dirty) {
+            if (!e.hasFront) return std::numeric_limits<float>::max();
+            float t;
+            if (world->rayHitsShape(e.front, origin, dir, t)) return t;
+            // Grazing the front's end in float: let the BVH decide
+        }
+        return trace(e, origin, dir);
+    }
+
+    // The rays computeVisibilityPolygon would cast (corners of edges in
+    // range, once per edge; circles in range), in its order.
+    void emit(sf::Vector2f origin) {
+        const Aabb lit{ origin.x - range, origin.y - range, origin.x + range, origin.y + range };
+        std::fill(pointUses.begin(), pointUses.end(), 0);
+        for (const EdgeInfo& e : edges) {
+            if (!e.box.overlaps(lit)) continue;
+            pointUses[e.a]++;
+            pointUses[e.b]++;
+        }
+        for (std::size_t i = 0; i < points.size(); ++i) {
+            if (pointUses[i]) pointAngle[i] = std::atan2(points[i].y - origin.y, points[i].x - origin.x);
+        }
+        for (CircleInfo& ci : circles) {
+            ci.lit = ci.box.overlaps(lit);
+            if (!ci.lit) continue;
+            sf::Vector2f d = ci.c.c - origin;
+            ci.mid = std::atan2(d.y, d.x);
+            ci.half = std::asin(ci.c.r / std::sqrt(d.x * d.x + d.y * d.y));
+        }
+
+        out.clear();
+        for (std::uint32_t idx : order) {
+            Element& e = elems[idx];
+            int copies = 1;
+            float angle = e.angle;
+            if (e.kind == POINT_RAY) {
+                copies = pointUses[e.id];
+                if (copies == 0) continue;
+                float a = pointAngle[e.id];
+                angle = e.sub < 0 ? a - VISIBILITY_EPS : e.sub > 0 ? a + VISIBILITY_EPS : a;
+            }
+            else if (e.kind == CIRCLE_RAY) {
+                if (!circles[e.id].lit) continue;
+                angle = circleRayAngle(circles[e.id], e.sub);
+            }
+            else if (e.kind != ARC_RAY) continue;
+
+            sf::Vector2f dir(std::cos(angle), std::sin(angle));
+            float t = hitDistance(e, origin, dir);
+            if (e.kind == POINT_RAY && e.sub == 0) {
+                // Stops at its own corner, as in the full cast
+                sf::Vector2f v = points[e.id] - origin;
+                t = std::min(t, std::sqrt(v.x * v.x + v.y * v.y));
+            }
+            if (!(t < range)) t = range;
+            sf::Vector2f p(origin.x + dir.x * t, origin.y + dir.y * t);
+            for (int c = 0; c < copies; ++c) out.push_back({ angle, p });
+        }
+
+        // Cyclic order -> ascending angle: start at the smallest, then move the
+        // few rays that wrapped past +-pi (and float near-ties) into place.
+        std::rotate(out.begin(), std::min_element(out.begin(), out.end(), [](const RayOut& l, const RayOut& r) { return l.angle < r.angle; }), out.end());
+        for (std::size_t i = 1; i < out.size(); ++i) {
+            RayOut r = out[i];
+            std::size_t j = i;
+            for (; j > 0 && out[j - 1].angle > r.angle; --j) out[j] = out[j - 1];
+            out[j] = r;
+        }
+
+        poly.clear();
+        for (const RayOut& r : out) poly.push_back(r.p);
+        st.rays = static_cast<std::uint32_t>(out.size());
+    }
+
+    const WorldGeometry* world = nullptr;
+    float range = 0.f;
+    sf::Vector2f buildOrigin, lastOrigin;
+
+    std::vector<EdgeInfo> edges;
+    std::vector<CircleInfo> circles;
+    Aabb candidateBox = Aabb::empty();
+    std::vector<sf::Vector2f> points;
+    std::vector<sf::Vector2f> crossings;
+    std::vector<std::uint32_t> sweep;   // findCrossings scratch: edge and circle ids by box.minX
+    std::vector<int> pointUses;
+    std::vector<float> pointAngle;
+    std::vector<Element> elems;
+    std::vector<std::uint32_t> order;   // cyclic, by key direction
+
+    double travel = 0.0;                       // px the light has moved since the build
+    std::vector<Cert> due;                     // min-heap on 'at'
+    std::vector<std::uint32_t> certVersion;    // by position in 'order'
+    std::vector<std::uint32_t> work;           // positions to check now
+    std::vector<std::uint8_t> queued;          // by position: already in 'work'
+
+    std::uint32_t stamp = 0;
+    std::vector<std::uint32_t> edgeStamp;     // == stamp: edge is a candidate
+    std::vector<std::uint32_t> circleStamp;
+
+    std::vector<RayOut> out;
+    std::vector<sf::Vector2f> poly;
+    Stats st;
+};
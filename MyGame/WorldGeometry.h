@@ -0,0 +1,309 @@
+// WorldGeometry.h
+// All solid geometry of the loaded level: axis-aligned rects, convex polygons,
+// circles and the tile grid, plus the straight edges that block light.
+// Everything except the grid cells goes into one ShapeBvh, which both the
+// player collision test and the visibility ray casts go through.
+// With quantizeEdges set, the edges are kept as 16-bit chunk-local integers
+// (QuantizedEdges) instead of float Segments, halving their footprint.
+// With spatialOrder set (the default), build() stores the shapes in the order
+// the BVH leaves visit them, so each leaf reads one contiguous run of every
+// array instead of hopping around authoring order.
+// Every array comes from one std::pmr resource (the level arena in the game)
+// and is sized exactly once, so nothing is left behind in a bump allocator.
+
+#pragma once
+
+#include "Geometry.h"
+#include "OccupancyGrid.h"
+#include "QuantizedEdges.h"
+#include "ShapeBvh.h"
+#include <memory_resource>
+#include <vector>
+
+struct WorldGeometry {
+    std::pmr::vector<sf::FloatRect> rects;
+    std::pmr::vector<ConvexPoly> polys;   // vertex lists stay on the heap
+    std::pmr::vector<CircleObstacle> circles;
+    OccupancyGrid grid;
+
+    // Every straight light-blocking edge: rect sides, polygon sides, grid boundary.
+    std::pmr::vector<Segment> segs;
+    ShapeBvh bvh;
+
+    // Set before build(); survives clear(). When the edges were quantized,
+    // 'segs' is emptied and 'qedges' holds them instead.
+    bool quantizeEdges = false;
+    bool spatialOrder = true;
+    QuantizedEdges qedges;
+
+    bool edgesQuantized() const { return !qedges.empty(); }
+    std::size_t edgeCount() const { return edgesQuantized() ? qedges.edges.size() : segs.size(); }
+    std::size_t edgeBytes() const { return edgesQuantized() ? qedges.bytes() : segs.size() * sizeof(Segment); }
+
+    WorldGeometry() = default;
+    explicit WorldGeometry(std::pmr::memory_resource* mem)
+        : rects(mem), polys(mem), circles(mem), grid(mem), segs(mem), bvh(mem), qedges(mem) {}
+
+    // Empties everything and hands the storage back to the resource, so an
+    // arena behind it can be released afterwards.
+    void clear() {
+        std::pmr::vector<sf::FloatRect>(rects.get_allocator()).swap(rects);
+        std::pmr::vector<ConvexPoly>(polys.get_allocator()).swap(polys);
+        std::pmr::vector<CircleObstacle>(circles.get_allocator()).swap(circles);
+        grid.clear();
+        std::pmr::vector<Segment>(segs.get_allocator()).swap(segs);
+        qedges.clear();
+        bvh.clear();
+    }
+
+    // Derive edges and rebuild the index after the shape arrays were filled.
+    void build() {
+        // Edges about to be quantized are gathered on the heap, so their float
+        // copy never takes up room in an arena that can't give it back.
+        std::vector<Segment> gridSegs = grid.extractBoundary();
+        std::pmr::vector<Segment> edges(quantizeEdges ? std::pmr::get_default_resource() : segs.get_allocator().resource());
+        std::size_t edgeTotal = 4 * rects.size() + gridSegs.size();
+        for (const auto& p : polys) edgeTotal += p.pts.size();
+        edges.reserve(edgeTotal);
+        for (const auto& b : rects) {
+            sf::Vector2f p1(b.position.x, b.position.y);
+            sf::Vector2f p2(b.position.x + b.size.x, b.position.y);
+            sf::Vector2f p3(b.position.x + b.size.x, b.position.y + b.size.y);
+            sf::Vector2f p4(b.position.x, b.position.y + b.size.y);
+            edges.push_back({ p1, p2 });
+            edges.push_back({ p2, p3 });
+            edges.push_back({ p3, p4 });
+            edges.push_back({ p4, p1 });
+        }
+        for (const auto& p : polys) {
+            for (std::size_t i = 0; i < p.pts.size(); ++i) {
+                edges.push_back({ p.pts[i], p.pts[(i + 1) % p.pts.size()] });
+            }
+        }
+        edges.insert(edges.end(), gridSegs.begin(), gridSegs.end());
+        if (spatialOrder) sortAlongCurve(edges);
+
+        qedges.clear();
+        std::pmr::vector<Segment>(segs.get_allocator()).swap(segs);
+        if (!(quantizeEdges && qedges.build(edges))) segs = std::move(edges);
+
+        std::pmr::vector<ShapeRef> items(bvh.refs.get_allocator());
+        std::pmr::vector<Aabb> boxes(bvh.boxes.get_allocator());
+        items.reserve(rects.size() + polys.size() + circles.size() + edgeCount());
+        boxes.reserve(items.capacity());
+
+        for (std::uint32_t i = 0; i < rects.size(); ++i) {
+            items.push_back({ ShapeKind::Rect, 0, i });
+            boxes.push_back(Aabb::fromRect(rects[i]));
+        }
+        for (std::uint32_t i = 0; i < polys.size(); ++i) {
+            items.push_back({ ShapeKind::Poly, 0, i });
+            boxes.push_back(Aabb::fromRect(polyBounds(polys[i])));
+        }
+        for (std::uint32_t i = 0; i < circles.size(); ++i) {
+            const auto& c = circles[i];
+            items.push_back({ ShapeKind::Circle, 0, i });
+            boxes.push_back({ c.c.x - c.r, c.c.y - c.r, c.c.x + c.r, c.c.y + c.r });
+        }
+        auto edgeBox = [](const Segment& s) -> Aabb {
+            return { std::min(s.a.x, s.b.x), std::min(s.a.y, s.b.y), std::max(s.a.x, s.b.x), std::max(s.a.y, s.b.y) };
+            };
+        if (edgesQuantized()) {
+            // Boxes come from the snapped coordinates so they bound what is tested
+            for (std::uint16_t c = 0; c < qedges.chunkCount(); ++c) {
+                for (std::uint32_t i = qedges.chunkFirst[c]; i < qedges.chunkFirst[c + 1]; ++i) {
+                    items.push_back({ ShapeKind::Edge, c, i });
+                    boxes.push_back(edgeBox(qedges.segment(c, i)));
+                }
+            }
+        }
+        else {
+            for (std::uint32_t i = 0; i < segs.size(); ++i) {
+                items.push_back({ ShapeKind::Edge, 0, i });
+                boxes.push_back(edgeBox(segs[i]));
+            }
+        }
+        bvh.build(std::move(items), std::move(boxes));
+        if (spatialOrder) packLeaves();
+    }
+
+    // Does a circle of radius r at c overlap any solid shape?
+    bool circleBlocked(const sf::Vector2f& c, float r) const {
+        if (grid.overlapsCircle(c, r)) return true;
+
+        bool blocked = false;
+        bvh.queryAabb({ c.x - r, c.y - r, c.x + r, c.y + r }, [&](ShapeRef ref) {
+            if (blocked) return;
+            switch (ref.kind) {
+            case ShapeKind::Rect:   blocked = circleIntersectsRect(c, r, rects[ref.index]); break;
+            case ShapeKind::Poly:   blocked = circleIntersectsPoly(c, r, polys[ref.index]); break;
+            case ShapeKind::Circle: blocked = circleIntersectsCircle(c, r, circles[ref.index].c, circles[ref.index].r); break;
+            case ShapeKind::Edge:   break;
+            }
+            });
+        return blocked;
+    }
+
+    // Can a circle of radius r slide in a straight line from a to b without
+    // touching anything? 'a' must be free. A circle that overlaps a solid
+    // shape without containing its centre also overlaps one of its edges, so
+    // edges (rect, polygon and grid sides alike) and circles are all it tests.
+    bool hasClearPath(const sf::Vector2f& a, const sf::Vector2f& b, float r) const {
+        const float r2 = r * r;
+        return !bvh.anyAlongSegment(a, b, r, [&](ShapeRef ref) {
+            if (ref.kind == ShapeKind::Edge) {
+                Segment s = edgeSegment(ref);
+                return segmentDistanceSq(a, b, s.a, s.b) < r2;
+            }
+            if (ref.kind == ShapeKind::Circle) {
+                const CircleObstacle& c = circles[ref.index];
+                return pointSegmentDistanceSq(c.c, a, b) < (c.r + r) * (c.r + r);
+            }
+            return false;
+            });
+    }
+
+    // Light-blocking edge behind an Edge ref, in world floats.
+    Segment edgeSegment(ShapeRef ref) const {
+        return edgesQuantized() ? qedges.segment(ref.chunk, ref.index) : segs[ref.index];
+    }
+
+    // Ray origin + t*dir (dir unit length) against one BVH item; false for
+    // rects and polygons, whose sides are separate Edge items.
+    bool rayHitsShape(ShapeRef ref, const sf::Vector2f& origin, const sf::Vector2f& dir, float& t) const {
+        if (ref.kind == ShapeKind::Edge) {
+            if (edgesQuantized()) return qedges.raycast(ref.chunk, ref.index, origin, dir, t);
+            const Segment& s = segs[ref.index];
+            sf::Vector2f hp;
+            return raySegmentIntersect(origin, dir, s.a, s.b - s.a, t, hp);
+        }
+        if (ref.kind == ShapeKind::Circle) return rayCircleIntersect(origin, dir, circles[ref.index], t);
+        return false;
+    }
+
+    // Nearest light blocker along origin + t*dir (dir unit length) with t <= maxDist.
+    // Returns the hit distance, or maxDist when nothing is in the way.
+    float raycast(const sf::Vector2f& origin, const sf::Vector2f& dir, float maxDist) const {
+        float tMax = maxDist;
+        bvh.raycast(origin, dir, tMax, [&](ShapeRef ref, float best, float& t) {
+            return rayHitsShape(ref, origin, dir, t) && t < best;
+            });
+        return tMax;
+    }
+
+    // raycast() for 'count' rays from one origin, in ShapeBvh::PACKET-sized
+    // packets; adjacent rays should be adjacent in angle. dist[i] gets the
+    // same value raycast(origin, dirs[i], maxDist) would return.
+    void raycastPacket(const sf::Vector2f& origin, const sf::Vector2f* dirs, std::size_t count, float maxDist, float* dist) const {
+        constexpr int P = ShapeBvh::PACKET;
+        for (std::size_t base = 0; base < count; base += P) {
+            std::size_t n = std::min<std::size_t>(P, count - base);
+            sf::Vector2f d[P];
+            float tMax[P];
+            for (int l = 0; l < P; ++l) {
+                d[l] = dirs[base + std::min<std::size_t>(l, n - 1)];
+                tMax[l] = maxDist;
+            }
+
+            bvh.raycastPacket(origin, d, tMax, [&](ShapeRef ref, float* tm) {
+                if (ref.kind == ShapeKind::Edge) {
+                    if (edgesQuantized()) {
+                        for (int l = 0; l < P; ++l) {
+                            float t;
+                            if (qedges.raycast(ref.chunk, ref.index, origin, d[l], t) && t < tm[l]) tm[l] = t;
+                        }
+                        return;
+                    }
+                    // raySegmentIntersect across the lanes; the edge-only terms are shared
+                    const Segment& sg = segs[ref.index];
+                    sf::Vector2f q = sg.a - origin;
+                    sf::Vector2f sv = sg.b - sg.a;
+                    float qxs = cross2(q, sv);
+                    for (int l = 0; l < P; ++l) {
+                        float rxs = cross2(d[l], sv);
+                        bool ok = std::fabs(rxs) >= 1e-8f;
+                        float safe = ok ? rxs : 1.f;
+                        float t = qxs / safe;
+                        float u = cross2(q, d[l]) / safe;
+                        ok = ok && t >= 0.f && u >= 0.f && u <= 1.f && t < tm[l];
+                        tm[l] = ok ? t : tm[l];
+                    }
+                }
+                else if (ref.kind == ShapeKind::Circle) {
+                    for (int l = 0; l < P; ++l) {
+                        float t;
+                        if (rayCircleIntersect(origin, d[l], circles[ref.index], t) && t < tm[l]) tm[l] = t;
+                    }
+                }
+                });
+
+            for (std::size_t l = 0; l < n; ++l) dist[base + l] = tMax[l];
+        }
+    }
+
+    // Visit the edges and circles that can matter for a light of radius 'range' at 'origin'.
+    template <typename FEdge, typename FCircle>
+    void forEachOccluderNear(const sf::Vector2f& origin, float range, FEdge&& onEdge, FCircle&& onCircle) const {
+        bvh.queryAabb({ origin.x - range, origin.y - range, origin.x + range, origin.y + range }, [&](ShapeRef ref) {
+            if (ref.kind == ShapeKind::Edge) onEdge(edgeSegment(ref));
+            else if (ref.kind == ShapeKind::Circle) onCircle(circles[ref.index]);
+            });
+    }
+
+private:
+    // Morton order by centre over the level's extent. Edges matter most here:
+    // quantized edges keep this order inside each chunk.
+    void sortAlongCurve(std::pmr::vector<Segment>& edges) {
+        Aabb ext = Aabb::empty();
+        for (const auto& sg : edges) ext.grow({ std::min(sg.a.x, sg.b.x), std::min(sg.a.y, sg.b.y), std::max(sg.a.x, sg.b.x), std::max(sg.a.y, sg.b.y) });
+        for (const auto& c : circles) ext.grow({ c.c.x - c.r, c.c.y - c.r, c.c.x + c.r, c.c.y + c.r });
+        if (ext.minX > ext.maxX) return;
+        sf::Vector2f lo(ext.minX, ext.minY), hi(ext.maxX, ext.maxY);
+
+        sortByMorton(rects, lo, hi, [](const sf::FloatRect& r) { return r.position + r.size * 0.5f; });
+        sortByMorton(polys, lo, hi, [](const ConvexPoly& p) { return Aabb::fromRect(polyBounds(p)).center(); });
+        sortByMorton(circles, lo, hi, [](const CircleObstacle& c) { return c.c; });
+        sortByMorton(edges, lo, hi, [](const Segment& sg) { return (sg.a + sg.b) * 0.5f; });
+    }
+
+    // Renumber every shape in BVH leaf order (refs are already stored leaf by
+    // leaf), so a leaf's shapes of one kind are consecutive in their array.
+    // Quantized edges stay grouped by chunk and are left alone. The new order
+    // is staged on the heap and written back over the old, in place.
+    void packLeaves() {
+        std::vector<sf::FloatRect> r;
+        std::vector<ConvexPoly> p;
+        std::vector<CircleObstacle> c;
+        std::vector<Segment> e;
+        r.reserve(rects.size());
+        p.reserve(polys.size());
+        c.reserve(circles.size());
+        e.reserve(segs.size());
+
+        for (ShapeRef& ref : bvh.refs) {
+            switch (ref.kind) {
+            case ShapeKind::Rect:
+                r.push_back(rects[ref.index]);
+                ref.index = static_cast<std::uint32_t>(r.size() - 1);
+                break;
+            case ShapeKind::Poly:
+                p.push_back(std::move(polys[ref.index]));
+                ref.index = static_cast<std::uint32_t>(p.size() - 1);
+                break;
+            case ShapeKind::Circle:
+                c.push_back(circles[ref.index]);
+                ref.index = static_cast<std::uint32_t>(c.size() - 1);
+                break;
+            case ShapeKind::Edge:
+                if (edgesQuantized()) break;
+                e.push_back(segs[ref.index]);
+                ref.index = static_cast<std::uint32_t>(e.size() - 1);
+                break;
+            }
+        }
+        std::copy(r.begin(), r.end(), rects.begin());
+        std::move(p.begin(), p.end(), polys.begin());
+        std::copy(c.begin(), c.end(), circles.begin());
+        if (!edgesQuantized()) std::copy(e.begin(), e.end(), segs.begin());
+    }
+};